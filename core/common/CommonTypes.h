@@ -22,5 +22,33 @@ enum MaterialClippingMode
 {
     no_clipping = 0,
     plane = 1,
-    sphere = 2
+    sphere = 2,
+    box = 3
+};
+
+// Features of the advanced renderer that its specialized kernels are compiled
+// with or without
+enum RendererFeature
+{
+    feature_shadows = 1,
+    feature_indirect_lighting = 2,
+    feature_volumes = 4,
+    feature_clipping = 8,
+    feature_simulation = 16,
+    feature_shading_modes = 32,
+    feature_all = 63
+};
+
+// Work counted for every pixel by the renderers when render statistics are
+// enabled
+enum RenderCounter
+{
+    counter_samples = 0,
+    counter_cycles = 1,
+    counter_camera_rays = 2,
+    counter_shadow_rays = 3,
+    counter_indirect_rays = 4,
+    counter_simulation_rays = 5,
+    counter_volume_samples = 6,
+    nb_render_counters = 7
 };
@@ -24,3 +24,4 @@
 /** Additional marterial attributes */
 const std::string MATERIAL_PROPERTY_CAST_USER_DATA = "cast_simulation_data";
 const std::string MATERIAL_PROPERTY_CLIPPING_MODE = "clipping_mode";
+const std::string MATERIAL_PROPERTY_SIMULATION_MAPPING = "simulation_mapping";
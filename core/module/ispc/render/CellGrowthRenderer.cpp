@@ -34,6 +34,12 @@ void CellGrowthRenderer::commit()
 
     _simulationThreshold = getParam1f("simulationThreshold", 0.f);
 
+    // The growth follows the animation (one micron per frame) unless a growth
+    // distance is explicitly specified
+    _growthDistance = getParam1f("growthDistance", -1.f);
+    if (_growthDistance < 0.f)
+        _growthDistance = _timestamp;
+
     _shadows = getParam1f("shadows", 0.f);
     _softShadows = getParam1f("softShadows", 0.f);
     _shadowDistance = getParam1f("shadowDistance", 1e4f);
@@ -45,7 +51,8 @@ void CellGrowthRenderer::commit()
         (_bgMaterial ? _bgMaterial->getIE() : nullptr), spp, _lightPtr,
         _lightArray.size(),
         (_simulationData ? (float*)_simulationData->data : nullptr),
-        _simulationDataSize, _alphaCorrection, _simulationThreshold, _exposure,
+        _simulationDataSize, _alphaCorrection, _simulationThreshold,
+        _growthDistance, _exposure,
         _fogThickness, _fogStart, _shadows, _softShadows, _shadowDistance,
         _useTransferFunctionColor, _useHardwareRandomizer);
 }
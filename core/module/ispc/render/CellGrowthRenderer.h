@@ -24,7 +24,9 @@ namespace circuitexplorer
 {
 /**
  * @brief The CellGrowthRenderer class can perform fast transparency
- * and mapping of simulation data on the geometry
+ * and mapping of simulation data on the geometry. The simulation offset of
+ * each primitive is its distance to the soma, and only primitives closer to
+ * the soma than the growth distance are rendered.
  */
 class CellGrowthRenderer : public CircuitExplorerSimulationRenderer
 {
@@ -40,6 +42,7 @@ public:
 
 private:
     float _simulationThreshold{0.f};
+    float _growthDistance{0.f};
 
     float _shadows{0.f};
     float _softShadows{0.f};
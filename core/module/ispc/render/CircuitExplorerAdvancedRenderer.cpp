@@ -24,6 +24,8 @@
 // ospray
 #include <ospray/SDK/common/Data.h>
 #include <ospray/SDK/common/Model.h>
+#include <ospray/SDK/fb/FrameBuffer.h>
+#include <ospray/SDK/geometry/Geometry.h>
 
 // ispc exports
 #include "CircuitExplorerAdvancedRenderer_ispc.h"
@@ -32,6 +34,57 @@ using namespace ospray;
 
 namespace circuitexplorer
 {
+namespace
+{
+int32 getClippingMode(const Material* material)
+{
+    const auto circuitExplorerMaterial =
+        dynamic_cast<const CircuitExplorerMaterial*>(material);
+    return circuitExplorerMaterial ? circuitExplorerMaterial->clippingMode
+                                   : MaterialClippingMode::no_clipping;
+}
+
+bool hasSpecificShadingMode(const Material* material)
+{
+    const auto circuitExplorerMaterial =
+        dynamic_cast<const CircuitExplorerMaterial*>(material);
+    if (!circuitExplorerMaterial)
+        return false;
+    switch (circuitExplorerMaterial->shadingMode)
+    {
+    case MaterialShadingMode::electron:
+    case MaterialShadingMode::cartoon:
+    case MaterialShadingMode::electron_transparency:
+    case MaterialShadingMode::perlin:
+    case MaterialShadingMode::checker:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Calls the function for every material of the geometries, until it returns
+// false
+template <typename F>
+void forEachMaterial(const std::vector<Geometry*>& geometries,
+                     const F& function)
+{
+    for (const auto geometry : geometries)
+    {
+        if (geometry->materialListData)
+        {
+            const auto materials =
+                (Material**)geometry->materialListData->data;
+            for (size_t i = 0; i < geometry->materialListData->numItems; ++i)
+                if (!function(materials[i]))
+                    return;
+        }
+        else if (!function(geometry->material.ptr))
+            return;
+    }
+}
+} // namespace
+
 void CircuitExplorerAdvancedRenderer::commit()
 {
     CircuitExplorerSimulationRenderer::commit();
@@ -50,9 +103,24 @@ void CircuitExplorerAdvancedRenderer::commit()
     _volumeSamplesPerRay = getParam1i("volumeSamplesPerRay", 32);
     _volumeSpecularExponent = getParam1f("volumeSpecularExponent", 20.f);
     _volumeAlphaCorrection = getParam1f("volumeAlphaCorrection", 0.5f);
+    _volumePreintegration = getParam("volumePreintegration", 0);
 
     _matrixFilter = getParam("matrixFilter", 0);
 
+    _adaptiveSamplingThreshold = getParam1f("adaptiveSamplingThreshold", 0.f);
+    _adaptiveSamplingMinSamples = getParam1i("adaptiveSamplingMinSamples", 8);
+
+    _specializedKernels = getParam("specializedKernels", 1);
+
+    _lightSamples = getParam1i("lightSamples", 0);
+
+    _denoise = getParam("denoise", 0);
+    if (!_denoise)
+    {
+        _denoiserAlbedo.clear();
+        _denoiserNormal.clear();
+    }
+
     const uint64 simulationDataSize =
         _simulationData ? _simulationData->size() : 0;
 
@@ -60,6 +128,7 @@ void CircuitExplorerAdvancedRenderer::commit()
     const auto clipPlaneData = clipPlanes ? clipPlanes->data : nullptr;
     const uint32 numClipPlanes = clipPlanes ? clipPlanes->numItems : 0;
 
+    const int32 sceneClippingMode = _getSceneClippingMode();
     ispc::CircuitExplorerAdvancedRenderer_set(
         getIE(), (_secondaryModel ? _secondaryModel->getIE() : nullptr),
         _maxDistanceToSecondaryModel,
@@ -69,9 +138,115 @@ void CircuitExplorerAdvancedRenderer::commit()
         _volumeSamplesPerRay,
         _simulationData ? (float*)_simulationData->data : nullptr,
         simulationDataSize, _samplingThreshold, _volumeSpecularExponent,
-        _volumeAlphaCorrection, _exposure, _fogThickness, _fogStart,
-        (const ispc::vec4f*)clipPlaneData, numClipPlanes, _maxBounces,
-        _epsilonFactor, _useHardwareRandomizer, _matrixFilter);
+        _volumeAlphaCorrection, _volumePreintegration, _exposure,
+        _fogThickness, _fogStart, (const ispc::vec4f*)clipPlaneData,
+        numClipPlanes, sceneClippingMode, _maxBounces, _epsilonFactor,
+        _useHardwareRandomizer, _matrixFilter);
+
+    ispc::CircuitExplorerAdvancedRenderer_setFeatures(
+        getIE(), _specializedKernels
+                     ? _getFeatures(numClipPlanes, sceneClippingMode)
+                     : RendererFeature::feature_all);
+
+    ispc::CircuitExplorerAdvancedRenderer_setLightSamples(getIE(),
+                                                          _lightSamples);
+
+    ispc::CircuitExplorerAdvancedRenderer_setAdaptiveSampling(
+        getIE(), _adaptiveSamplingThreshold, _adaptiveSamplingMinSamples,
+        _pixelStatistics.empty() ? nullptr : _pixelStatistics.data());
+
+    ispc::CircuitExplorerAdvancedRenderer_setDenoiserBuffers(
+        getIE(), _denoiserAlbedo.empty() ? nullptr : _denoiserAlbedo.data(),
+        _denoiserNormal.empty() ? nullptr : _denoiserNormal.data());
+}
+
+void* CircuitExplorerAdvancedRenderer::beginFrame(FrameBuffer* fb)
+{
+    // Pixel statistics are reset by the renderer with the first sample of
+    // every accumulation, the buffer only needs to follow the frame size
+    if (_adaptiveSamplingThreshold > 0.f)
+    {
+        const size_t size =
+            size_t(fb->size.x) * fb->size.y *
+            ispc::CircuitExplorerAdvancedRenderer_getPixelStatisticsSize();
+        if (_pixelStatistics.size() != size)
+        {
+            _pixelStatistics.resize(size);
+            ispc::CircuitExplorerAdvancedRenderer_setAdaptiveSampling(
+                getIE(), _adaptiveSamplingThreshold,
+                _adaptiveSamplingMinSamples, _pixelStatistics.data());
+        }
+    }
+
+    // Albedo and normal buffers guiding the denoiser are accumulated by the
+    // renderer along with the colors
+    if (_denoise)
+    {
+        const size_t size = size_t(fb->size.x) * fb->size.y;
+        if (_denoiserAlbedo.size() != size)
+        {
+            _denoiserAlbedo.resize(size);
+            _denoiserNormal.resize(size);
+            ispc::CircuitExplorerAdvancedRenderer_setDenoiserBuffers(
+                getIE(), _denoiserAlbedo.data(), _denoiserNormal.data());
+        }
+    }
+    return CircuitExplorerSimulationRenderer::beginFrame(fb);
+}
+
+void CircuitExplorerAdvancedRenderer::endFrame(void* perFrameData,
+                                               const int32 fbChannelFlags)
+{
+    if (_denoise && !_denoiserAlbedo.empty())
+        _denoiser.denoise(currentFB, _denoiserAlbedo.data(),
+                          _denoiserNormal.data());
+    CircuitExplorerSimulationRenderer::endFrame(perFrameData, fbChannelFlags);
+}
+
+int32 CircuitExplorerAdvancedRenderer::_getSceneClippingMode() const
+{
+    std::vector<Geometry*> geometries;
+    _collectGeometries(model, geometries);
+
+    int32 sceneClippingMode = MaterialClippingMode::no_clipping;
+    bool first = true;
+    forEachMaterial(geometries, [&](const Material* material) {
+        const auto clippingMode = getClippingMode(material);
+        if (first)
+            sceneClippingMode = clippingMode;
+        else if (clippingMode != sceneClippingMode)
+            sceneClippingMode = -1;
+        first = false;
+        return sceneClippingMode != -1;
+    });
+    return sceneClippingMode;
+}
+
+uint32 CircuitExplorerAdvancedRenderer::_getFeatures(
+    const uint32 numClipPlanes, const int32 sceneClippingMode) const
+{
+    uint32 features = 0;
+    if (_shadows > 0.f)
+        features |= RendererFeature::feature_shadows;
+    if (_giStrength >= _samplingThreshold)
+        features |= RendererFeature::feature_indirect_lighting;
+    if (model && !model->volume.empty())
+        features |= RendererFeature::feature_volumes;
+    if (numClipPlanes > 0 &&
+        sceneClippingMode != MaterialClippingMode::no_clipping)
+        features |= RendererFeature::feature_clipping;
+    if (_simulationData)
+        features |= RendererFeature::feature_simulation;
+
+    std::vector<Geometry*> geometries;
+    _collectGeometries(model, geometries);
+    forEachMaterial(geometries, [&](const Material* material) {
+        if (!hasSpecificShadingMode(material))
+            return true;
+        features |= RendererFeature::feature_shading_modes;
+        return false;
+    });
+    return features;
 }
 
 CircuitExplorerAdvancedRenderer::CircuitExplorerAdvancedRenderer()
@@ -19,6 +19,7 @@
 #pragma once
 
 #include "utils/CircuitExplorerSimulationRenderer.h"
+#include "utils/Denoiser.h"
 
 namespace circuitexplorer
 {
@@ -41,8 +42,27 @@ public:
         return "CircuitExplorerAdvancedRenderer";
     }
     void commit() final;
+    void* beginFrame(ospray::FrameBuffer* fb) final;
+    void endFrame(void* perFrameData, const ospray::int32 fbChannelFlags) final;
 
 private:
+    /**
+     * Detects scenes where all materials share the same clipping mode. The
+     * renderer then restricts the traced rays to the interval left visible by
+     * the clipping volumes, so that clipped geometry is never intersected.
+     * Returns -1 when materials use different clipping modes.
+     */
+    ospray::int32 _getSceneClippingMode() const;
+
+    /**
+     * Returns the features required by the committed parameters and the
+     * materials of the scene. The renderer selects the cheapest of its kernel
+     * variants compiled with these features, the code of the other features
+     * being removed from the variant.
+     */
+    ospray::uint32 _getFeatures(const ospray::uint32 numClipPlanes,
+                                const ospray::int32 sceneClippingMode) const;
+
     // Shading
     float _shadows{0.f};
     float _softShadows{0.f};
@@ -62,6 +82,24 @@ private:
     ospray::int32 _volumeSamplesPerRay{32};
     float _volumeSpecularExponent{10.f};
     float _volumeAlphaCorrection{0.5f};
+    bool _volumePreintegration{false};
+
+    // Number of lights picked for shadows, all lights are traced when 0
+    ospray::uint32 _lightSamples{0};
+
+    // Kernel variants
+    bool _specializedKernels{true};
+
+    // Adaptive sampling
+    float _adaptiveSamplingThreshold{0.f};
+    ospray::uint32 _adaptiveSamplingMinSamples{8};
+    std::vector<ospray::uint8> _pixelStatistics;
+
+    // Denoising
+    bool _denoise{false};
+    Denoiser _denoiser;
+    std::vector<ospray::vec3f> _denoiserAlbedo;
+    std::vector<ospray::vec3f> _denoiserNormal;
 
     // Clip planes
     ospray::Ref<ospray::Data> clipPlanes;
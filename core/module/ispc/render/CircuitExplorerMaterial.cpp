@@ -90,6 +90,11 @@ void CircuitExplorerMaterial::commit()
         getParam1i(MATERIAL_PROPERTY_CLIPPING_MODE.c_str(),
                    static_cast<int>(MaterialClippingMode::no_clipping)));
 
+    // Simulation mapping
+    simulationMapping = SimulationMapping::find(
+        getParam1i(MATERIAL_PROPERTY_SIMULATION_MAPPING.c_str(),
+                   SimulationMapping::NO_MAPPING));
+
     ispc::CircuitExplorerMaterial_set(
         getIE(), map_d ? map_d->getIE() : nullptr,
         (const ispc::AffineSpace2f&)xform_d, d,
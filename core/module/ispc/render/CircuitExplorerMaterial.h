@@ -18,6 +18,8 @@
 
 #pragma once
 
+#include "utils/SimulationMapping.h"
+
 #include <common/CommonTypes.h>
 
 #include <brayns/common/CommonTypes.h>
@@ -87,6 +89,9 @@ struct CircuitExplorerMaterial : public ospray::Material
     /*! User parameter */
     float userParameter;
 
+    /*! Simulation offsets mapped to the vertices of the mesh */
+    SimulationMappingPtr simulationMapping;
+
     std::string toString() const final { return "default_material"; }
     void commit() final;
 };
@@ -35,6 +35,16 @@ void ProximityDetectionRenderer::commit()
     _surfaceShadingEnabled = bool(getParam1i("surfaceShadingEnabled", 1));
     _randomNumber = getParam1i("randomNumber", 0);
     _alphaCorrection = getParam1f("alphaCorrection", 0.5f);
+    _exactDetection = bool(getParam1i("exactDetection", 1));
+
+    // The analysis is only run again when the geometry or the detection
+    // parameters change
+    ProximityAnalysisDescriptor analysis{nullptr, nullptr, nullptr, 0};
+    if (_exactDetection &&
+        _analysis.update(model, _detectionDistance,
+                         _detectionOnDifferentMaterial))
+        analysis = _analysis.getDescriptor();
+    ispc::ProximityDetectionRenderer_setAnalysis(getIE(), &analysis);
 
     ispc::ProximityDetectionRenderer_set(
         getIE(), (_bgMaterial ? _bgMaterial->getIE() : nullptr),
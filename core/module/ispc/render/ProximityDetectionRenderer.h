@@ -19,6 +19,7 @@
 #pragma once
 
 #include "utils/CircuitExplorerAbstractRenderer.h"
+#include "utils/ProximityAnalysis.h"
 
 namespace circuitexplorer
 {
@@ -32,12 +33,17 @@ namespace circuitexplorer
    the maximum distance between the intersection and the surrounding geometry.
 
     Surrounding geometry is detected by sending random rays from the
-    intersection point of the surface.
+    intersection point of the surface. When exact detection is enabled, the
+    distances between spheres, cylinders and cones are computed once on the
+    CPU when the geometry changes, and looked up per primitive at render time.
+    Random rays are then only used for the other types of geometry.
 
     This renderer can be configured using the following entries:
     - detectionDistance: Maximum distance for surrounding geometry detection
     - materialTestEnabled: If true, detection will be disabled for geometry that
     has the same material as the hit surface.
+    - exactDetection: If true, proximity is computed by a CPU analysis of the
+    primitives rather than by random rays
     - spp: Unsigned integer defining the number of samples per pixel
 */
 class ProximityDetectionRenderer : public CircuitExplorerAbstractRenderer
@@ -64,5 +70,8 @@ private:
     bool _surfaceShadingEnabled{true};
     ospray::uint32 _randomNumber{0};
     float _alphaCorrection{0.5f};
+    bool _exactDetection{true};
+
+    ProximityAnalysis _analysis;
 };
 } // namespace circuitexplorer
@@ -24,15 +24,37 @@
 // ispc exports
 #include "VoxelizedSimulationRenderer_ispc.h"
 
+#include <algorithm>
+
 using namespace ospray;
 
 namespace circuitexplorer
 {
+// Must match the maximum value of the gridResolution renderer property
+const int MAX_GRID_RESOLUTION = 1024;
+
 void VoxelizedSimulationRenderer::commit()
 {
     CircuitExplorerSimulationRenderer::commit();
 
     _simulationThreshold = getParam1f("simulationThreshold", 0.f);
+    // The grid is disabled by default, the renderer then traverses the
+    // geometry as it did before the grid was introduced
+    _gridResolution = std::min(
+        MAX_GRID_RESOLUTION, std::max(0, getParam1i("gridResolution", 0)));
+
+    // Simulation values are splatted into the grid for every frame. Without
+    // simulation data, the renderer traverses the geometry instead
+    SimulationGridDescriptor grid{nullptr, {0, 0, 0}, {}, {}};
+    if (_simulationData && _bakedTransferFunction.size > 0 &&
+        _gridResolution > 0 && _grid.update(model, _gridResolution))
+    {
+        _grid.splat((const float*)_simulationData->data, _simulationDataSize,
+                    _transferFunctionTable, _bakedTransferFunction.scale,
+                    _bakedTransferFunction.offset);
+        grid = _grid.getDescriptor();
+    }
+    ispc::VoxelizedSimulationRenderer_setGrid(getIE(), &grid);
 
     ispc::VoxelizedSimulationRenderer_set(
         getIE(), (_secondaryModel ? _secondaryModel->getIE() : nullptr),
@@ -19,12 +19,16 @@
 #pragma once
 
 #include "utils/CircuitExplorerSimulationRenderer.h"
+#include "utils/SimulationGrid.h"
 
 namespace circuitexplorer
 {
 /**
  * @brief The VoxelizedSimulationRenderer class can perform fast transparency
- * and mapping of simulation data on the geometry
+ * and mapping of simulation data on the geometry. When the gridResolution
+ * property is not 0, simulation values are splatted into a uniform grid that
+ * is ray-marched by the renderer, the cost of a frame being bounded by the
+ * resolution of the grid rather than by the depth complexity of the scene
  */
 class VoxelizedSimulationRenderer : public CircuitExplorerSimulationRenderer
 {
@@ -40,6 +44,8 @@ public:
 
 private:
     float _simulationThreshold{0.f};
+    ospray::uint32 _gridResolution{0};
+    SimulationGrid _grid;
 };
 
 } // namespace circuitexplorer
@@ -18,10 +18,19 @@
 
 #include "CircuitExplorerAbstractRenderer.h"
 
+// cameras
+#include <module/ispc/camera/DOFPerspectiveCamera.h>
+#include <module/ispc/camera/SphereClippingPerspectiveCamera.h>
+
 // ospray
 #include <ospray/SDK/common/Data.h>
+#include <ospray/SDK/fb/FrameBuffer.h>
 #include <ospray/SDK/lights/Light.h>
 
+// ispc exports
+#include "RenderStatistics_ispc.h"
+#include "utils_ispc.h"
+
 namespace circuitexplorer
 {
 void CircuitExplorerAbstractRenderer::commit()
@@ -45,6 +54,33 @@ void CircuitExplorerAbstractRenderer::commit()
     _exposure = getParam1f("exposure", 1.f);
 
     _useHardwareRandomizer = getParam("useHardwareRandomizer", 0);
+
+    _renderStatistics = getParam("renderStatistics", 0);
+    if (!_renderStatistics)
+        _statistics.clear();
+}
+
+void* CircuitExplorerAbstractRenderer::beginFrame(ospray::FrameBuffer* fb)
+{
+    // Counters are cleared for every frame, including accumulation frames
+    ispc::RenderStatistics_set(getIE(), _renderStatistics
+                                            ? _statistics.beginFrame(fb->size)
+                                            : nullptr);
+
+    // Cameras of the module decorrelate the lens samples of the pixels
+    if (dynamic_cast<ospray::DOFPerspectiveCamera*>(camera.ptr) ||
+        dynamic_cast<ospray::SphereClippingPerspectiveCamera*>(camera.ptr))
+        ispc::LensSampler_setFrameSize(camera->getIE(),
+                                       (const ispc::vec2i&)fb->size);
+    return Renderer::beginFrame(fb);
+}
+
+void CircuitExplorerAbstractRenderer::endFrame(
+    void* perFrameData, const ospray::int32 fbChannelFlags)
+{
+    if (_renderStatistics)
+        _statistics.endFrame(toString());
+    Renderer::endFrame(perFrameData, fbChannelFlags);
 }
 
 } // namespace circuitexplorer
@@ -20,6 +20,7 @@
 
 // obj
 #include "../CircuitExplorerMaterial.h"
+#include "RenderStatistics.h"
 
 // ospray
 #include <ospray/SDK/common/Material.h>
@@ -38,6 +39,9 @@ class CircuitExplorerAbstractRenderer : public ospray::Renderer
 {
 public:
     void commit() override;
+    void* beginFrame(ospray::FrameBuffer* fb) override;
+    void endFrame(void* perFrameData,
+                  const ospray::int32 fbChannelFlags) override;
 
 protected:
     bool _useHardwareRandomizer;
@@ -51,5 +55,9 @@ protected:
     float _timestamp{0.f};
     ospray::uint32 _maxBounces{10};
     float _exposure{1.f};
+
+    // Render statistics
+    bool _renderStatistics{false};
+    RenderStatisticsCollector _statistics;
 };
 } // namespace circuitexplorer
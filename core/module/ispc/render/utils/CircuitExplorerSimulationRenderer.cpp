@@ -31,28 +31,55 @@
 
 #include <ospray/SDK/geometry/Cylinders.h>
 #include <ospray/SDK/geometry/Geometry.h>
+#include <ospray/SDK/geometry/Instance.h>
 #include <ospray/SDK/geometry/Spheres.h>
 
 #include <ospray/SDK/transferFunction/TransferFunction.h>
+#include <ospray/SDK/volume/Volume.h>
 
-extern "C"
+#include <algorithm>
+#include <cstddef>
+
+namespace
 {
-    int CircuitExplorerSimulationRenderer_getBytesPerPrimitive(
-        const void* geometry)
-    {
-        const ospray::Geometry* base =
-            static_cast<const ospray::Geometry*>(geometry);
-        if (dynamic_cast<const ospray::Spheres*>(base))
-            return sizeof(brayns::Sphere);
-        else if (dynamic_cast<const ospray::Cylinders*>(base))
-            return sizeof(brayns::Cylinder);
-        else if (dynamic_cast<const ospray::Cones*>(base))
-            return sizeof(brayns::Cone);
-        else if (dynamic_cast<const ospray::SDFGeometries*>(base))
-            return sizeof(brayns::SDFGeometry);
-        return 0;
-    }
+circuitexplorer::SimulationGeometryLayout getGeometryLayout(
+    const ospray::Geometry* geometry)
+{
+    // Simulation offsets are stored in the userData member of the primitives
+    if (dynamic_cast<const ospray::Spheres*>(geometry))
+        return {sizeof(brayns::Sphere), offsetof(brayns::Sphere, userData),
+                nullptr, 0};
+    if (dynamic_cast<const ospray::Cylinders*>(geometry))
+        return {sizeof(brayns::Cylinder), offsetof(brayns::Cylinder, userData),
+                nullptr, 0};
+    if (dynamic_cast<const ospray::Cones*>(geometry))
+        return {sizeof(brayns::Cone), offsetof(brayns::Cone, userData),
+                nullptr, 0};
+    if (dynamic_cast<const ospray::SDFGeometries*>(geometry))
+        return {sizeof(brayns::SDFGeometry),
+                offsetof(brayns::SDFGeometry, userData), nullptr, 0};
+    return {0, 0, nullptr, 0};
+}
+
+// Number of entries of the baked transfer functions
+const size_t TRANSFER_FUNCTION_TABLE_SIZE = 1024;
+
+template <typename T>
+T sampleLinearly(const T* values, const size_t nbValues, const float position)
+{
+    const float x = position * (nbValues - 1);
+    const size_t index = std::min(size_t(x), nbValues - 1);
+    const size_t next = std::min(index + 1, nbValues - 1);
+    const float weight = x - index;
+    return values[index] * (1.f - weight) + values[next] * weight;
+}
+
+// Must match the hash function of the ISPC renderers
+size_t getGeometrySlot(const ospray::uint64 key, const size_t mask)
+{
+    return ((key >> 4) * 2654435761ull) & mask;
 }
+} // namespace
 
 namespace circuitexplorer
 {
@@ -77,6 +104,201 @@ void CircuitExplorerSimulationRenderer::commit()
     if (transferFunction)
         ispc::CircuitExplorerSimulationRenderer_setTransferFunction(
             getIE(), transferFunction->getIE());
+    _bakeTransferFunctions(transferFunction);
+
+    _commitGeometryLayouts();
+    _commitOpacity();
+}
+
+bool CircuitExplorerSimulationRenderer::_isOpaque(
+    const ospray::Material* material)
+{
+    const auto circuitExplorerMaterial =
+        dynamic_cast<const CircuitExplorerMaterial*>(material);
+    if (!circuitExplorerMaterial)
+        return false;
+    return circuitExplorerMaterial->d >= 1.f &&
+           !circuitExplorerMaterial->map_d &&
+           !circuitExplorerMaterial->map_Kd;
+}
+
+void CircuitExplorerSimulationRenderer::_commitOpacity()
+{
+    // Only the geometry of the scene model can cast shadows
+    std::vector<ospray::Geometry*> geometries;
+    _collectGeometries(model, geometries);
+
+    bool opaque = true;
+    for (const auto geometry : geometries)
+    {
+        if (geometry->materialListData)
+        {
+            const auto materials =
+                (ospray::Material**)geometry->materialListData->data;
+            for (size_t i = 0;
+                 opaque && i < geometry->materialListData->numItems; ++i)
+                opaque = _isOpaque(materials[i]);
+        }
+        else
+            opaque = _isOpaque(geometry->material.ptr);
+        if (!opaque)
+            break;
+    }
+    ispc::CircuitExplorerSimulationRenderer_setOpaqueScene(getIE(), opaque);
+}
+
+BakedTransferFunction CircuitExplorerSimulationRenderer::_bakeTransferFunction(
+    ospray::TransferFunction* transferFunction,
+    std::vector<ospray::vec4f>& table, std::vector<ospray::vec4f>& integral)
+{
+    table.clear();
+    integral.clear();
+    BakedTransferFunction baked{nullptr, nullptr, 0, 0.f, 0.f};
+    if (!transferFunction)
+        return baked;
+
+    const auto colors = transferFunction->getParamData("colors", nullptr);
+    const auto opacities = transferFunction->getParamData("opacities", nullptr);
+    if (!colors || !opacities || colors->numItems == 0 ||
+        opacities->numItems == 0)
+        return baked;
+
+    const auto range = transferFunction->getParam2f("valueRange",
+                                                    ospray::vec2f(0.f, 1.f));
+    if (range.y <= range.x)
+        return baked;
+
+    const auto colorValues = (const ospray::vec3f*)colors->data;
+    const auto opacityValues = (const float*)opacities->data;
+    table.resize(TRANSFER_FUNCTION_TABLE_SIZE);
+    for (size_t i = 0; i < TRANSFER_FUNCTION_TABLE_SIZE; ++i)
+    {
+        const float position = float(i) / (TRANSFER_FUNCTION_TABLE_SIZE - 1);
+        const auto color =
+            sampleLinearly(colorValues, colors->numItems, position);
+        const auto opacity =
+            sampleLinearly(opacityValues, opacities->numItems, position);
+        table[i] = ospray::vec4f(color.x, color.y, color.z, opacity);
+    }
+
+    // Running integral, in table units, of the opacity-weighted colors (xyz)
+    // and of the opacity (w). Entries being linearly interpolated, each
+    // interval contributes the average of its two ends
+    integral.resize(TRANSFER_FUNCTION_TABLE_SIZE);
+    integral[0] = ospray::vec4f(0.f);
+    for (size_t i = 1; i < TRANSFER_FUNCTION_TABLE_SIZE; ++i)
+    {
+        const auto& a = table[i - 1];
+        const auto& b = table[i];
+        integral[i] =
+            integral[i - 1] +
+            0.5f * ospray::vec4f(a.x * a.w + b.x * b.w, a.y * a.w + b.y * b.w,
+                                 a.z * a.w + b.z * b.w, a.w + b.w);
+    }
+
+    baked.table = table.data();
+    baked.integral = integral.data();
+    baked.size = table.size();
+    baked.scale = (TRANSFER_FUNCTION_TABLE_SIZE - 1) / (range.y - range.x);
+    baked.offset = -range.x * baked.scale;
+    return baked;
+}
+
+void CircuitExplorerSimulationRenderer::_bakeTransferFunctions(
+    ospray::TransferFunction* transferFunction)
+{
+    _bakedTransferFunction =
+        _bakeTransferFunction(transferFunction, _transferFunctionTable,
+                              _transferFunctionIntegral);
+
+    _volumeKeys.clear();
+    _volumeTransferFunctions.clear();
+    _volumeMacrocellGrids.clear();
+    const size_t nbVolumes = model ? model->volume.size() : 0;
+    _volumeTransferFunctionTables.resize(nbVolumes);
+    _volumeTransferFunctionIntegrals.resize(nbVolumes);
+    _volumeMacrocells.resize(nbVolumes);
+    for (size_t i = 0; i < nbVolumes; ++i)
+    {
+        const auto volume = model->volume[i].ptr;
+        const auto baked = _bakeTransferFunction(
+            (ospray::TransferFunction*)volume->getParamObject(
+                "transferFunction", nullptr),
+            _volumeTransferFunctionTables[i],
+            _volumeTransferFunctionIntegrals[i]);
+        if (baked.size == 0)
+            continue;
+        _volumeKeys.push_back((ospray::uint64)volume->getIE());
+        _volumeTransferFunctions.push_back(baked);
+
+        auto& macrocells = _volumeMacrocells[i];
+        if (macrocells.update(volume, _volumeTransferFunctionTables[i],
+                              baked.scale, baked.offset))
+            _volumeMacrocellGrids.push_back(macrocells.getGrid());
+        else
+            _volumeMacrocellGrids.push_back({nullptr, {0, 0, 0}, {}, {}});
+    }
+
+    ispc::CircuitExplorerSimulationRenderer_setBakedTransferFunctions(
+        getIE(), &_bakedTransferFunction, _volumeKeys.data(),
+        _volumeTransferFunctions.data(), _volumeMacrocellGrids.data(),
+        _volumeKeys.size());
+}
+
+void CircuitExplorerSimulationRenderer::_collectGeometries(
+    ospray::Model* model, std::vector<ospray::Geometry*>& geometries) const
+{
+    if (!model)
+        return;
+
+    for (const auto& geometry : model->geometry)
+    {
+        const auto instance = dynamic_cast<ospray::Instance*>(geometry.ptr);
+        if (instance)
+            _collectGeometries(instance->instancedScene.ptr, geometries);
+        else
+            geometries.push_back(geometry.ptr);
+    }
+}
+
+void CircuitExplorerSimulationRenderer::_commitGeometryLayouts()
+{
+    std::vector<ospray::Geometry*> geometries;
+    _collectGeometries(model, geometries);
+    _collectGeometries(_secondaryModel, geometries);
+
+    // Table is kept at most half full
+    size_t nbSlots = 1;
+    while (nbSlots < 2 * geometries.size())
+        nbSlots <<= 1;
+    const size_t mask = nbSlots - 1;
+    _geometryKeys.assign(nbSlots, 0);
+    _geometryLayouts.assign(nbSlots, {0, 0, nullptr, 0});
+    _simulationMappings.clear();
+    for (const auto geometry : geometries)
+    {
+        const auto key = (ospray::uint64)geometry->getIE();
+        size_t slot = getGeometrySlot(key, mask);
+        while (_geometryKeys[slot] != 0 && _geometryKeys[slot] != key)
+            slot = (slot + 1) & mask;
+        _geometryKeys[slot] = key;
+        _geometryLayouts[slot] = getGeometryLayout(geometry);
+
+        // Meshes mapped to the simulation at load time. Mappings are kept
+        // alive until the next commit
+        const auto mapping = getSimulationMapping(geometry);
+        if (mapping)
+        {
+            _geometryLayouts[slot].simulationMapping =
+                mapping->getOffsets().data();
+            _geometryLayouts[slot].nbMappedVertices =
+                mapping->getOffsets().size();
+            _simulationMappings.push_back(mapping);
+        }
+    }
+
+    ispc::CircuitExplorerSimulationRenderer_setGeometryLayouts(
+        getIE(), _geometryKeys.data(), _geometryLayouts.data(), mask);
 }
 
 } // namespace circuitexplorer
@@ -21,16 +21,47 @@
 // obj
 #include "../CircuitExplorerMaterial.h"
 #include "CircuitExplorerAbstractRenderer.h"
+#include "SimulationMapping.h"
+#include "VolumeMacrocells.h"
 
 // ospray
 #include <ospray/SDK/common/Material.h>
 #include <ospray/SDK/render/Renderer.h>
+#include <ospray/SDK/transferFunction/TransferFunction.h>
 
 // system
 #include <vector>
 
 namespace circuitexplorer
 {
+/**
+ * Layout of the simulation offsets in the primitives of a geometry, or offsets
+ * mapped to the vertices of a mesh. Must match the SimulationGeometryLayout
+ * structure of the ISPC renderers
+ */
+struct SimulationGeometryLayout
+{
+    int32_t bytesPerPrimitive;
+    int32_t userDataOffset;
+    const uint64_t* simulationMapping;
+    uint64_t nbMappedVertices;
+};
+
+/**
+ * Transfer function baked into a color (xyz) and opacity (w) table, indexed by
+ * value * scale + offset, along with the running integral of the table used for
+ * preintegration. Must match the BakedTransferFunction structure of the ISPC
+ * renderers
+ */
+struct BakedTransferFunction
+{
+    const ospray::vec4f* table;
+    const ospray::vec4f* integral;
+    uint32_t size;
+    float scale;
+    float offset;
+};
+
 /**
  * The CircuitExplorerSimulationRenderer class implements a parent renderer for
  * all Brayns renderers that need to render simulation data
@@ -41,6 +72,38 @@ public:
     void commit() override;
 
 protected:
+    /**
+     * Resolves, once per commit, the layout of the simulation offsets for all
+     * geometries of the scene and of the secondary model. Layouts are stored
+     * in an open addressing hash table, indexed by ISPC geometry, that the
+     * renderers read directly when shading an intersection.
+     */
+    void _commitGeometryLayouts();
+    void _collectGeometries(ospray::Model* model,
+                            std::vector<ospray::Geometry*>& geometries) const;
+
+    /**
+     * Detects scenes where every material is fully opaque. Renderers then
+     * resolve shadows with a single occlusion query instead of walking
+     * through the layers of transparent geometry.
+     */
+    void _commitOpacity();
+    static bool _isOpaque(const ospray::Material* material);
+
+    /**
+     * Bakes the simulation transfer function and the ones of the volumes of
+     * the scene into lookup tables, sparing the renderers the virtual calls to
+     * the transfer functions for every sample. Macrocells of the volumes are
+     * updated accordingly. Tables are complemented with the running integral
+     * of the opacity-weighted colors, from which renderers preintegrate the
+     * transfer function over the value range spanned by a ray segment.
+     */
+    void _bakeTransferFunctions(ospray::TransferFunction* transferFunction);
+    static BakedTransferFunction _bakeTransferFunction(
+        ospray::TransferFunction* transferFunction,
+        std::vector<ospray::vec4f>& table,
+        std::vector<ospray::vec4f>& integral);
+
     ospray::Model* _secondaryModel;
     float _maxDistanceToSecondaryModel{30.f};
 
@@ -51,5 +114,19 @@ protected:
 
     float _fogThickness{1e6f};
     float _fogStart{0.f};
+
+    std::vector<ospray::uint64> _geometryKeys;
+    std::vector<SimulationGeometryLayout> _geometryLayouts;
+    SimulationMappings _simulationMappings;
+
+    std::vector<ospray::vec4f> _transferFunctionTable;
+    std::vector<ospray::vec4f> _transferFunctionIntegral;
+    BakedTransferFunction _bakedTransferFunction{nullptr, nullptr, 0, 0.f, 0.f};
+    std::vector<std::vector<ospray::vec4f>> _volumeTransferFunctionTables;
+    std::vector<std::vector<ospray::vec4f>> _volumeTransferFunctionIntegrals;
+    std::vector<ospray::uint64> _volumeKeys;
+    std::vector<BakedTransferFunction> _volumeTransferFunctions;
+    std::vector<VolumeMacrocells> _volumeMacrocells;
+    std::vector<VolumeMacrocellGrid> _volumeMacrocellGrids;
 };
 } // namespace circuitexplorer
@@ -0,0 +1,149 @@
+/* Copyright (c) 2015-2018, EPFL/Blue Brain Project
+ * All rights reserved. Do not distribute without permission.
+ * Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "Denoiser.h"
+
+#include <common/Logs.h>
+
+#include <ospray/SDK/fb/LocalFB.h>
+
+#include <algorithm>
+#include <cmath>
+
+#ifdef USE_OIDN
+namespace
+{
+float toFloat(const unsigned char value)
+{
+    return value / 255.f;
+}
+
+unsigned char toByte(const float value)
+{
+    return static_cast<unsigned char>(
+        std::round(std::min(1.f, std::max(0.f, value)) * 255.f));
+}
+} // namespace
+#endif
+
+namespace circuitexplorer
+{
+bool Denoiser::denoise(ospray::FrameBuffer* frameBuffer,
+                       const ospray::vec3f* albedo, const ospray::vec3f* normal)
+{
+    const auto localFrameBuffer =
+        dynamic_cast<ospray::LocalFrameBuffer*>(frameBuffer);
+    if (!localFrameBuffer || !localFrameBuffer->colorBuffer)
+        return false;
+
+#ifdef USE_OIDN
+    const auto format = localFrameBuffer->colorBufferFormat;
+    if (format != OSP_FB_RGBA8 && format != OSP_FB_SRGBA &&
+        format != OSP_FB_RGBA32F)
+        return false;
+
+    const size_t width = localFrameBuffer->size.x;
+    const size_t height = localFrameBuffer->size.y;
+    const size_t nbPixels = width * height;
+    _color.resize(nbPixels);
+    _output.resize(nbPixels);
+
+    // Colors are produced in [0, 1] by the renderers, the filter is used in
+    // its low dynamic range mode
+    if (format == OSP_FB_RGBA32F)
+    {
+        const auto colors = (const ospray::vec4f*)localFrameBuffer->colorBuffer;
+        for (size_t i = 0; i < nbPixels; ++i)
+            _color[i] = ospray::vec3f(colors[i].x, colors[i].y, colors[i].z);
+    }
+    else
+    {
+        const auto colors = (const unsigned char*)localFrameBuffer->colorBuffer;
+        for (size_t i = 0; i < nbPixels; ++i)
+            _color[i] = ospray::vec3f(toFloat(colors[4 * i]),
+                                      toFloat(colors[4 * i + 1]),
+                                      toFloat(colors[4 * i + 2]));
+    }
+
+    _initialize();
+    _filter.setImage("color", _color.data(), oidn::Format::Float3, width,
+                     height);
+    _filter.setImage("albedo", (void*)albedo, oidn::Format::Float3, width,
+                     height);
+    _filter.setImage("normal", (void*)normal, oidn::Format::Float3, width,
+                     height);
+    _filter.setImage("output", _output.data(), oidn::Format::Float3, width,
+                     height);
+    _filter.set("hdr", false);
+    _filter.set("srgb", format == OSP_FB_SRGBA);
+    _filter.commit();
+    _filter.execute();
+
+    const char* message;
+    if (_device.getError(message) != oidn::Error::None)
+    {
+        PLUGIN_ERROR("Failed to denoise frame: " << message);
+        return false;
+    }
+
+    // Alpha is left untouched
+    if (format == OSP_FB_RGBA32F)
+    {
+        auto colors = (ospray::vec4f*)localFrameBuffer->colorBuffer;
+        for (size_t i = 0; i < nbPixels; ++i)
+        {
+            colors[i].x = _output[i].x;
+            colors[i].y = _output[i].y;
+            colors[i].z = _output[i].z;
+        }
+    }
+    else
+    {
+        auto colors = (unsigned char*)localFrameBuffer->colorBuffer;
+        for (size_t i = 0; i < nbPixels; ++i)
+        {
+            colors[4 * i] = toByte(_output[i].x);
+            colors[4 * i + 1] = toByte(_output[i].y);
+            colors[4 * i + 2] = toByte(_output[i].z);
+        }
+    }
+    return true;
+#else
+    if (!_warned)
+    {
+        PLUGIN_WARN(
+            "Denoising requires CircuitExplorer to be built with Open Image "
+            "Denoise");
+        _warned = true;
+    }
+    return false;
+#endif
+}
+
+#ifdef USE_OIDN
+void Denoiser::_initialize()
+{
+    if (_device)
+        return;
+
+    _device = oidn::newDevice(oidn::DeviceType::CPU);
+    _device.commit();
+    _filter = _device.newFilter("RT");
+}
+#endif
+} // namespace circuitexplorer
@@ -0,0 +1,63 @@
+/* Copyright (c) 2015-2018, EPFL/Blue Brain Project
+ * All rights reserved. Do not distribute without permission.
+ * Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#pragma once
+
+#include <Defines.h>
+
+#include <ospray/SDK/fb/FrameBuffer.h>
+
+#ifdef USE_OIDN
+#include <OpenImageDenoise/oidn.hpp>
+#endif
+
+#include <vector>
+
+namespace circuitexplorer
+{
+/**
+ * The Denoiser class removes the Monte Carlo noise from the color buffer of a
+ * local frame buffer, using Open Image Denoise on the CPU. Albedo and normal
+ * buffers produced by the renderer guide the filter so that edges and textures
+ * are preserved. Without Open Image Denoise support, frames are left unchanged.
+ */
+class Denoiser
+{
+public:
+    /**
+     * Denoises the color buffer of the frame buffer in place
+     * @param albedo Per-pixel albedo of the first visible surfaces
+     * @param normal Per-pixel normal of the first visible surfaces
+     * @return False if the frame buffer could not be denoised
+     */
+    bool denoise(ospray::FrameBuffer* frameBuffer, const ospray::vec3f* albedo,
+                 const ospray::vec3f* normal);
+
+private:
+#ifdef USE_OIDN
+    void _initialize();
+
+    oidn::DeviceRef _device;
+    oidn::FilterRef _filter;
+    std::vector<ospray::vec3f> _color;
+    std::vector<ospray::vec3f> _output;
+#else
+    bool _warned{false};
+#endif
+};
+} // namespace circuitexplorer
@@ -0,0 +1,371 @@
+/* Copyright (c) 2015-2018, EPFL/Blue Brain Project
+ * All rights reserved. Do not distribute without permission.
+ * Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "ProximityAnalysis.h"
+
+#include <brayns/ispc/geometry/Cones.h>
+
+#include <brayns/common/geometry/Cone.h>
+#include <brayns/common/geometry/Cylinder.h>
+#include <brayns/common/geometry/Sphere.h>
+
+#include <ospray/SDK/common/tasking/parallel_for.h>
+#include <ospray/SDK/geometry/Cylinders.h>
+#include <ospray/SDK/geometry/Instance.h>
+#include <ospray/SDK/geometry/Spheres.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+// Names of the geometry parameters holding the primitives
+const char* PARAM_SPHERES = "spheres";
+const char* PARAM_CYLINDERS = "cylinders";
+const char* PARAM_CONES = "cones";
+
+// Maximum number of cells of the acceleration grid along one axis
+const int MAX_GRID_RESOLUTION = 256;
+
+template <typename T>
+ospray::vec3f toVec3f(const T& v)
+{
+    return ospray::vec3f(v.x, v.y, v.z);
+}
+
+template <typename T>
+const T* getItems(ospray::Geometry* geometry, const char* name,
+                  size_t& nbItems)
+{
+    const auto data = geometry->getParamData(name, nullptr);
+    nbItems = data ? data->numBytes / sizeof(T) : 0;
+    return data ? (const T*)data->data : nullptr;
+}
+
+ospray::Data* getPrimitiveData(ospray::Geometry* geometry)
+{
+    if (dynamic_cast<ospray::Spheres*>(geometry))
+        return geometry->getParamData(PARAM_SPHERES, nullptr);
+    if (dynamic_cast<ospray::Cylinders*>(geometry))
+        return geometry->getParamData(PARAM_CYLINDERS, nullptr);
+    if (dynamic_cast<ospray::Cones*>(geometry))
+        return geometry->getParamData(PARAM_CONES, nullptr);
+    return nullptr;
+}
+
+// Identifies a geometry, its material and its primitives, so that the
+// analysis is run again when any of them changes
+void addToSignature(ospray::Geometry* geometry,
+                    std::vector<const void*>& signature)
+{
+    const auto data = getPrimitiveData(geometry);
+    signature.push_back(geometry);
+    signature.push_back(geometry->material.ptr);
+    signature.push_back(data);
+    signature.push_back((const void*)(data ? data->numBytes : 0));
+}
+
+bool overlap(const ospray::box3f& a, const ospray::box3f& b)
+{
+    return a.lower.x <= b.upper.x && b.lower.x <= a.upper.x &&
+           a.lower.y <= b.upper.y && b.lower.y <= a.upper.y &&
+           a.lower.z <= b.upper.z && b.lower.z <= a.upper.z;
+}
+
+// Parameters of the closest points of segments [p0, p1] and [q0, q1]
+void getClosestPoints(const ospray::vec3f& p0, const ospray::vec3f& p1,
+                      const ospray::vec3f& q0, const ospray::vec3f& q1,
+                      float& s, float& t)
+{
+    const ospray::vec3f d1 = p1 - p0;
+    const ospray::vec3f d2 = q1 - q0;
+    const ospray::vec3f r = p0 - q0;
+    const float a = dot(d1, d1);
+    const float e = dot(d2, d2);
+    const float f = dot(d2, r);
+    const float epsilon = 1e-12f;
+
+    if (a <= epsilon && e <= epsilon)
+    {
+        s = t = 0.f;
+        return;
+    }
+    if (a <= epsilon)
+    {
+        s = 0.f;
+        t = std::min(1.f, std::max(0.f, f / e));
+        return;
+    }
+
+    const float c = dot(d1, r);
+    if (e <= epsilon)
+    {
+        t = 0.f;
+        s = std::min(1.f, std::max(0.f, -c / a));
+        return;
+    }
+
+    const float b = dot(d1, d2);
+    const float denominator = a * e - b * b;
+    s = denominator > epsilon
+            ? std::min(1.f, std::max(0.f, (b * f - c * e) / denominator))
+            : 0.f;
+    t = (b * s + f) / e;
+    if (t < 0.f)
+    {
+        t = 0.f;
+        s = std::min(1.f, std::max(0.f, -c / a));
+    }
+    else if (t > 1.f)
+    {
+        t = 1.f;
+        s = std::min(1.f, std::max(0.f, (b - c) / a));
+    }
+}
+} // namespace
+
+namespace circuitexplorer
+{
+bool ProximityAnalysis::update(ospray::Model* model, const float distance,
+                               const bool differentMaterial)
+{
+    if (!model)
+        return false;
+
+    // The analysis is only run again when the geometry changes
+    std::vector<const void*> signature;
+    for (const auto& geometry : model->geometry)
+    {
+        const auto instance = dynamic_cast<ospray::Instance*>(geometry.ptr);
+        if (!instance || !instance->instancedScene)
+        {
+            addToSignature(geometry.ptr, signature);
+            continue;
+        }
+        signature.push_back(geometry.ptr);
+        for (const auto& g : instance->instancedScene->geometry)
+            addToSignature(g.ptr, signature);
+    }
+    if (signature == _signature && distance == _distance &&
+        differentMaterial == _differentMaterial)
+        return !_capsules.empty();
+    _signature = signature;
+    _distance = distance;
+    _differentMaterial = differentMaterial;
+
+    // Geometries are indexed the way Embree reports them: by instance, then
+    // by geometry within the instanced model
+    _capsules.clear();
+    _geometryOffsets.clear();
+    _instanceOffsets.clear();
+    for (const auto& geometry : model->geometry)
+    {
+        _instanceOffsets.push_back(_geometryOffsets.size());
+        const auto instance = dynamic_cast<ospray::Instance*>(geometry.ptr);
+        if (!instance || !instance->instancedScene)
+        {
+            _addGeometry(geometry.ptr, ospray::affine3f(ospcommon::one),
+                         differentMaterial);
+            continue;
+        }
+        for (const auto& g : instance->instancedScene->geometry)
+            _addGeometry(g.ptr, instance->xfm, differentMaterial);
+    }
+
+    _computeDistances(distance);
+    return !_capsules.empty();
+}
+
+ProximityAnalysisDescriptor ProximityAnalysis::getDescriptor() const
+{
+    if (_capsules.empty())
+        return {nullptr, nullptr, nullptr, 0};
+    return {_distances.data(), _geometryOffsets.data(),
+            _instanceOffsets.data(), ospray::uint32(_instanceOffsets.size())};
+}
+
+void ProximityAnalysis::_addGeometry(ospray::Geometry* geometry,
+                                     const ospray::affine3f& transform,
+                                     const bool differentMaterial)
+{
+    const void* group = geometry;
+    if (differentMaterial && geometry->material)
+        group = geometry->material.ptr;
+
+    const int64_t offset = _capsules.size();
+    size_t nbItems = 0;
+    if (dynamic_cast<ospray::Spheres*>(geometry))
+    {
+        const auto spheres =
+            getItems<brayns::Sphere>(geometry, PARAM_SPHERES, nbItems);
+        for (size_t i = 0; i < nbItems; ++i)
+        {
+            const auto center =
+                ospray::xfmPoint(transform, toVec3f(spheres[i].center));
+            _capsules.push_back({center, center, spheres[i].radius,
+                                 spheres[i].radius, group});
+        }
+    }
+    else if (dynamic_cast<ospray::Cylinders*>(geometry))
+    {
+        const auto cylinders =
+            getItems<brayns::Cylinder>(geometry, PARAM_CYLINDERS, nbItems);
+        for (size_t i = 0; i < nbItems; ++i)
+            _capsules.push_back(
+                {ospray::xfmPoint(transform, toVec3f(cylinders[i].center)),
+                 ospray::xfmPoint(transform, toVec3f(cylinders[i].up)),
+                 cylinders[i].radius, cylinders[i].radius, group});
+    }
+    else if (dynamic_cast<ospray::Cones*>(geometry))
+    {
+        const auto cones =
+            getItems<brayns::Cone>(geometry, PARAM_CONES, nbItems);
+        for (size_t i = 0; i < nbItems; ++i)
+            _capsules.push_back(
+                {ospray::xfmPoint(transform, toVec3f(cones[i].center)),
+                 ospray::xfmPoint(transform, toVec3f(cones[i].up)),
+                 cones[i].centerRadius, cones[i].upRadius, group});
+    }
+
+    _geometryOffsets.push_back(nbItems > 0 ? offset : -1);
+}
+
+void ProximityAnalysis::_computeDistances(const float distance)
+{
+    const size_t nbCapsules = _capsules.size();
+    _distances.assign(nbCapsules, std::numeric_limits<float>::infinity());
+    if (nbCapsules == 0)
+        return;
+
+    // Bounding boxes, expanded by half the detection distance so that two
+    // capsules closer than that distance have overlapping boxes
+    const float margin = 0.5f * distance;
+    std::vector<ospray::box3f> bounds(nbCapsules);
+    float averageExtent = 0.f;
+    for (size_t i = 0; i < nbCapsules; ++i)
+    {
+        const auto& capsule = _capsules[i];
+        const ospray::vec3f r0(capsule.r0 + margin);
+        const ospray::vec3f r1(capsule.r1 + margin);
+        bounds[i] = ospray::box3f(
+            ospray::min(capsule.p0 - r0, capsule.p1 - r1),
+            ospray::max(capsule.p0 + r0, capsule.p1 + r1));
+        averageExtent += reduce_max(bounds[i].size());
+    }
+    averageExtent /= nbCapsules;
+
+    ospray::box3f sceneBounds = bounds[0];
+    for (const auto& box : bounds)
+        sceneBounds.extend(box);
+
+    // Uniform grid of the bounding boxes, sized after the average primitive
+    const ospray::vec3f sceneSize = sceneBounds.size();
+    const float cellSize = std::max(
+        std::max(1e-6f, averageExtent),
+        reduce_max(sceneSize) / MAX_GRID_RESOLUTION);
+    ospray::vec3i dimensions;
+    for (size_t i = 0; i < 3; ++i)
+        dimensions[i] = std::max(
+            1, std::min(MAX_GRID_RESOLUTION,
+                        int(std::ceil(sceneSize[i] / cellSize))));
+
+    const auto getCell = [&](const ospray::vec3f& p) {
+        const auto c = (p - sceneBounds.lower) / cellSize;
+        return ospray::vec3i(std::min(int(c.x), dimensions.x - 1),
+                             std::min(int(c.y), dimensions.y - 1),
+                             std::min(int(c.z), dimensions.z - 1));
+    };
+    const auto getCellIndex = [&](const int x, const int y, const int z) {
+        return size_t(x) + dimensions.x * (size_t(y) + dimensions.y * z);
+    };
+
+    // Counting sort of the capsules by overlapped cell
+    const size_t nbCells = size_t(dimensions.x) * dimensions.y * dimensions.z;
+    std::vector<ospray::vec3i> lowerCells(nbCapsules);
+    std::vector<ospray::vec3i> upperCells(nbCapsules);
+    std::vector<size_t> cellOffsets(nbCells + 1, 0);
+    for (size_t i = 0; i < nbCapsules; ++i)
+    {
+        const auto& lo = lowerCells[i] = getCell(bounds[i].lower);
+        const auto& hi = upperCells[i] = getCell(bounds[i].upper);
+        for (int z = lo.z; z <= hi.z; ++z)
+            for (int y = lo.y; y <= hi.y; ++y)
+                for (int x = lo.x; x <= hi.x; ++x)
+                    ++cellOffsets[getCellIndex(x, y, z) + 1];
+    }
+    for (size_t i = 0; i < nbCells; ++i)
+        cellOffsets[i + 1] += cellOffsets[i];
+
+    std::vector<ospray::uint32> cellCapsules(cellOffsets.back());
+    std::vector<size_t> cursors(cellOffsets.begin(), cellOffsets.end() - 1);
+    for (size_t i = 0; i < nbCapsules; ++i)
+    {
+        const auto& lo = lowerCells[i];
+        const auto& hi = upperCells[i];
+        for (int z = lo.z; z <= hi.z; ++z)
+            for (int y = lo.y; y <= hi.y; ++y)
+                for (int x = lo.x; x <= hi.x; ++x)
+                    cellCapsules[cursors[getCellIndex(x, y, z)]++] = i;
+    }
+
+    // Capsules are independent from each other. A pair of capsules sharing
+    // several cells is only tested in the first of them
+    ospray::tasking::parallel_for(nbCapsules, [&](const int i) {
+        const auto& capsule = _capsules[i];
+        const auto& lo = lowerCells[i];
+        const auto& hi = upperCells[i];
+        float closest = std::numeric_limits<float>::infinity();
+        for (int z = lo.z; z <= hi.z; ++z)
+            for (int y = lo.y; y <= hi.y; ++y)
+                for (int x = lo.x; x <= hi.x; ++x)
+                {
+                    const size_t cell = getCellIndex(x, y, z);
+                    for (size_t k = cellOffsets[cell];
+                         k < cellOffsets[cell + 1]; ++k)
+                    {
+                        const auto j = cellCapsules[k];
+                        const auto& other = _capsules[j];
+                        if (other.group == capsule.group)
+                            continue;
+
+                        const auto& otherLo = lowerCells[j];
+                        if (x != std::max(lo.x, otherLo.x) ||
+                            y != std::max(lo.y, otherLo.y) ||
+                            z != std::max(lo.z, otherLo.z))
+                            continue;
+                        if (!overlap(bounds[i], bounds[j]))
+                            continue;
+
+                        float s, t;
+                        getClosestPoints(capsule.p0, capsule.p1, other.p0,
+                                         other.p1, s, t);
+                        const auto p = capsule.p0 + s * (capsule.p1 -
+                                                         capsule.p0);
+                        const auto q = other.p0 + t * (other.p1 - other.p0);
+                        const float radii =
+                            capsule.r0 + s * (capsule.r1 - capsule.r0) +
+                            other.r0 + t * (other.r1 - other.r0);
+                        closest = std::min(closest, length(p - q) - radii);
+                    }
+                }
+        if (closest <= distance)
+            _distances[i] = std::max(0.f, closest);
+    });
+}
+} // namespace circuitexplorer
@@ -0,0 +1,91 @@
+/* Copyright (c) 2015-2018, EPFL/Blue Brain Project
+ * All rights reserved. Do not distribute without permission.
+ * Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#pragma once
+
+#include <ospray/SDK/common/Model.h>
+
+#include <vector>
+
+namespace circuitexplorer
+{
+/**
+ * Per-primitive results of the proximity analysis. The distance of primitive
+ * primID of geometry geomID, instanced by top-level geometry instID, is
+ * distances[geometryOffsets[instanceOffsets[instID] + geomID] + primID].
+ * Geometries that were not analyzed have a negative offset. Must match the
+ * ProximityAnalysisDescriptor structure of the ISPC renderers
+ */
+struct ProximityAnalysisDescriptor
+{
+    const float* distances;
+    const int64_t* geometryOffsets;
+    const int32_t* instanceOffsets;
+    ospray::uint32 nbInstances;
+};
+
+/**
+ * The ProximityAnalysis class computes, for every sphere, cylinder and cone of
+ * a model, the distance to the closest primitive that belongs to a different
+ * group, up to a maximum detection distance. Groups are either the materials
+ * or the geometries of the model. Primitives are handled as capsules whose
+ * radius varies linearly along their axis, and candidates are found with a
+ * uniform grid of their bounding boxes. The analysis is only run again when
+ * the geometry or the detection parameters change.
+ */
+class ProximityAnalysis
+{
+public:
+    /**
+     * Analyzes the primitives of the model, if the geometry or the detection
+     * parameters changed since the last update
+     * @param distance Maximum distance between two primitives
+     * @param differentMaterial If true, primitives are grouped by material,
+     * by geometry otherwise
+     * @return False if the model has no primitive that can be analyzed
+     */
+    bool update(ospray::Model* model, const float distance,
+                const bool differentMaterial);
+
+    ProximityAnalysisDescriptor getDescriptor() const;
+
+private:
+    struct Capsule
+    {
+        ospray::vec3f p0;
+        ospray::vec3f p1;
+        float r0;
+        float r1;
+        const void* group;
+    };
+
+    void _addGeometry(ospray::Geometry* geometry,
+                      const ospray::affine3f& transform,
+                      const bool differentMaterial);
+    void _computeDistances(const float distance);
+
+    std::vector<const void*> _signature;
+    float _distance{0.f};
+    bool _differentMaterial{true};
+
+    std::vector<Capsule> _capsules;
+    std::vector<float> _distances;
+    std::vector<int64_t> _geometryOffsets;
+    std::vector<int32_t> _instanceOffsets;
+};
+} // namespace circuitexplorer
@@ -0,0 +1,85 @@
+/* Copyright (c) 2015-2018, EPFL/Blue Brain Project
+ * All rights reserved. Do not distribute without permission.
+ * Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "RenderStatistics.h"
+
+#include <common/CommonTypes.h>
+
+#include <mutex>
+
+namespace
+{
+std::mutex lastFrameMutex;
+circuitexplorer::RenderStatistics lastFrame;
+} // namespace
+
+namespace circuitexplorer
+{
+ospray::uint32* RenderStatisticsCollector::beginFrame(
+    const ospray::vec2i& frameSize)
+{
+    _frameSize = frameSize;
+    _pixelCounters.assign(size_t(frameSize.x) * frameSize.y *
+                              RenderCounter::nb_render_counters,
+                          0);
+    return _pixelCounters.data();
+}
+
+void RenderStatisticsCollector::endFrame(const std::string& renderer)
+{
+    if (_pixelCounters.empty())
+        return;
+
+    RenderStatistics statistics;
+    statistics.available = true;
+    statistics.renderer = renderer;
+    statistics.frameSize = _frameSize;
+    statistics.tileSize = ospray::vec2i(TILE_SIZE);
+    statistics.nbTiles = (_frameSize + TILE_SIZE - 1) / TILE_SIZE;
+    statistics.counters.resize(RenderCounter::nb_render_counters, 0);
+    statistics.tileCosts.resize(
+        size_t(statistics.nbTiles.x) * statistics.nbTiles.y, 0);
+
+    const ospray::uint32* counters = _pixelCounters.data();
+    for (int y = 0; y < _frameSize.y; ++y)
+        for (int x = 0; x < _frameSize.x; ++x)
+        {
+            for (size_t i = 0; i < RenderCounter::nb_render_counters; ++i)
+                statistics.counters[i] += counters[i];
+            statistics.tileCosts[(y / TILE_SIZE) * statistics.nbTiles.x +
+                                 x / TILE_SIZE] +=
+                counters[RenderCounter::counter_cycles];
+            counters += RenderCounter::nb_render_counters;
+        }
+
+    std::lock_guard<std::mutex> lock(lastFrameMutex);
+    lastFrame = std::move(statistics);
+}
+
+void RenderStatisticsCollector::clear()
+{
+    _pixelCounters.clear();
+    _pixelCounters.shrink_to_fit();
+}
+
+RenderStatistics RenderStatisticsCollector::getLastFrameStatistics()
+{
+    std::lock_guard<std::mutex> lock(lastFrameMutex);
+    return lastFrame;
+}
+} // namespace circuitexplorer
@@ -0,0 +1,72 @@
+/* Copyright (c) 2015-2018, EPFL/Blue Brain Project
+ * All rights reserved. Do not distribute without permission.
+ * Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#pragma once
+
+#include <ospray/SDK/common/OSPCommon.h>
+
+#include <string>
+#include <vector>
+
+namespace circuitexplorer
+{
+/**
+ * Statistics of the last frame rendered with render statistics enabled.
+ * Counters are indexed by RenderCounter, and tile costs are the cycles spent
+ * on the tiles of the frame, row by row
+ */
+struct RenderStatistics
+{
+    bool available{false};
+    std::string renderer;
+    ospray::vec2i frameSize{0, 0};
+    ospray::vec2i tileSize{0, 0};
+    ospray::vec2i nbTiles{0, 0};
+    std::vector<ospray::uint64> counters;
+    std::vector<ospray::uint64> tileCosts;
+};
+
+/**
+ * The RenderStatisticsCollector class holds the per-pixel counters filled by
+ * the renderers during a frame, and aggregates them per tile at the end of the
+ * frame. Aggregated statistics are shared by all renderers of the process, so
+ * that the plugin API can expose the statistics of the last rendered frame.
+ */
+class RenderStatisticsCollector
+{
+public:
+    /**
+     * Resizes and clears the per-pixel counters for a new frame
+     * @return Counters to be filled by the renderer
+     */
+    ospray::uint32* beginFrame(const ospray::vec2i& frameSize);
+
+    /** Aggregates the counters of the frame and publishes the statistics */
+    void endFrame(const std::string& renderer);
+
+    /** Releases the per-pixel counters */
+    void clear();
+
+    /** @return The statistics of the last published frame */
+    static RenderStatistics getLastFrameStatistics();
+
+private:
+    ospray::vec2i _frameSize{0, 0};
+    std::vector<ospray::uint32> _pixelCounters;
+};
+} // namespace circuitexplorer
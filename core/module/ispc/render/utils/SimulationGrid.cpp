@@ -0,0 +1,310 @@
+/* Copyright (c) 2015-2018, EPFL/Blue Brain Project
+ * All rights reserved. Do not distribute without permission.
+ * Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "SimulationGrid.h"
+#include "SimulationMapping.h"
+
+#include <brayns/ispc/geometry/Cones.h>
+#include <brayns/ispc/geometry/SDFGeometries.h>
+
+#include <brayns/common/geometry/Cone.h>
+#include <brayns/common/geometry/Cylinder.h>
+#include <brayns/common/geometry/SDFGeometry.h>
+#include <brayns/common/geometry/Sphere.h>
+
+#include <ospray/SDK/common/tasking/parallel_for.h>
+#include <ospray/SDK/geometry/Cylinders.h>
+#include <ospray/SDK/geometry/Instance.h>
+#include <ospray/SDK/geometry/Spheres.h>
+#include <ospray/SDK/geometry/TriangleMesh.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+// Names of the geometry parameters holding the primitives
+const char* PARAM_SPHERES = "spheres";
+const char* PARAM_CYLINDERS = "cylinders";
+const char* PARAM_CONES = "cones";
+const char* PARAM_SDF_GEOMETRIES = "sdfgeometries";
+const char* PARAM_VERTICES = "vertex";
+
+template <typename T>
+ospray::vec3f toVec3f(const T& v)
+{
+    return ospray::vec3f(v.x, v.y, v.z);
+}
+
+// Adds the primitives of a geometry, positioned at their center and carrying
+// the simulation offset of their userData member. Geometries that are not
+// attached to a simulation leave the userData of all their primitives to 0,
+// they are skipped rather than colored with the first simulation value
+template <typename T, typename GetPosition, typename Primitives>
+void addPrimitives(const ospray::Data* data, const ospray::affine3f& transform,
+                   const GetPosition& getPosition, Primitives& primitives)
+{
+    if (!data)
+        return;
+
+    const auto items = (const T*)data->data;
+    const size_t nbItems = data->numBytes / sizeof(T);
+    if (std::all_of(items, items + nbItems,
+                    [](const T& item) { return item.userData == 0; }))
+        return;
+
+    for (size_t i = 0; i < nbItems; ++i)
+        primitives.push_back(
+            {ospray::xfmPoint(transform, getPosition(items[i])),
+             items[i].userData});
+}
+
+// Adds the vertices of a mesh, carrying the simulation offsets mapped to them
+// at load time
+template <typename Primitives>
+void addMeshPrimitives(ospray::Geometry* geometry,
+                       const ospray::affine3f& transform,
+                       Primitives& primitives)
+{
+    const auto vertices = geometry->getParamData(PARAM_VERTICES, nullptr);
+    const auto mapping = circuitexplorer::getSimulationMapping(geometry);
+    if (!vertices || !mapping)
+        return;
+
+    const size_t stride = ospray::sizeOf(vertices->type);
+    if (stride < sizeof(ospray::vec3f))
+        return;
+
+    const auto& offsets = mapping->getOffsets();
+    const size_t nbVertices =
+        std::min(vertices->numBytes / stride, offsets.size());
+    for (size_t i = 0; i < nbVertices; ++i)
+    {
+        if (offsets[i] == circuitexplorer::SimulationMapping::UNMAPPED_VERTEX)
+            continue;
+        const auto& vertex =
+            *(const ospray::vec3f*)((const char*)vertices->data + i * stride);
+        primitives.push_back({ospray::xfmPoint(transform, vertex), offsets[i]});
+    }
+}
+
+ospray::Data* getPrimitiveData(ospray::Geometry* geometry)
+{
+    if (dynamic_cast<ospray::Spheres*>(geometry))
+        return geometry->getParamData(PARAM_SPHERES, nullptr);
+    if (dynamic_cast<ospray::Cylinders*>(geometry))
+        return geometry->getParamData(PARAM_CYLINDERS, nullptr);
+    if (dynamic_cast<ospray::Cones*>(geometry))
+        return geometry->getParamData(PARAM_CONES, nullptr);
+    if (dynamic_cast<ospray::SDFGeometries*>(geometry))
+        return geometry->getParamData(PARAM_SDF_GEOMETRIES, nullptr);
+    if (dynamic_cast<ospray::TriangleMesh*>(geometry))
+        return geometry->getParamData(PARAM_VERTICES, nullptr);
+    return nullptr;
+}
+
+ospray::vec4f getTransferFunctionValue(const std::vector<ospray::vec4f>& table,
+                                       const float scale, const float offset,
+                                       const float value)
+{
+    const float last = table.size() - 1;
+    const float x = std::min(last, std::max(0.f, value * scale + offset));
+    const size_t index = std::min(size_t(x), table.size() - 2);
+    const float weight = x - index;
+    return table[index] * (1.f - weight) + table[index + 1] * weight;
+}
+} // namespace
+
+namespace circuitexplorer
+{
+bool SimulationGrid::update(ospray::Model* model,
+                            const ospray::uint32 resolution)
+{
+    std::vector<std::pair<ospray::Geometry*, ospray::affine3f>> geometries;
+    _collectGeometries(model, ospray::affine3f(ospcommon::one), geometries);
+
+    // Primitives are only reassigned when the geometry changes
+    std::vector<const void*> signature;
+    for (const auto& geometry : geometries)
+    {
+        const auto data = getPrimitiveData(geometry.first);
+        signature.push_back(geometry.first);
+        signature.push_back(data);
+        signature.push_back((const void*)(data ? data->numBytes : 0));
+        signature.push_back(getSimulationMapping(geometry.first).get());
+    }
+    if (signature == _signature && resolution == _resolution)
+        return !_cells.empty();
+    _signature = signature;
+    _resolution = resolution;
+
+    std::vector<Primitive> primitives;
+    for (const auto& geometry : geometries)
+    {
+        const auto g = geometry.first;
+        const auto& transform = geometry.second;
+        if (dynamic_cast<ospray::Spheres*>(g))
+            addPrimitives<brayns::Sphere>(
+                getPrimitiveData(g), transform,
+                [](const brayns::Sphere& s) { return toVec3f(s.center); },
+                primitives);
+        else if (dynamic_cast<ospray::Cylinders*>(g))
+            addPrimitives<brayns::Cylinder>(
+                getPrimitiveData(g), transform,
+                [](const brayns::Cylinder& c) {
+                    return toVec3f((c.center + c.up) * 0.5f);
+                },
+                primitives);
+        else if (dynamic_cast<ospray::Cones*>(g))
+            addPrimitives<brayns::Cone>(
+                getPrimitiveData(g), transform,
+                [](const brayns::Cone& c) {
+                    return toVec3f((c.center + c.up) * 0.5f);
+                },
+                primitives);
+        else if (dynamic_cast<ospray::SDFGeometries*>(g))
+            addPrimitives<brayns::SDFGeometry>(
+                getPrimitiveData(g), transform,
+                [](const brayns::SDFGeometry& s) {
+                    return toVec3f((s.p0 + s.p1) * 0.5f);
+                },
+                primitives);
+        else if (dynamic_cast<ospray::TriangleMesh*>(g))
+            addMeshPrimitives(g, transform, primitives);
+    }
+
+    _assignPrimitives(primitives, resolution);
+    return !_cells.empty();
+}
+
+void SimulationGrid::splat(const float* simulationData,
+                           const ospray::uint64 size,
+                           const std::vector<ospray::vec4f>& table,
+                           const float scale, const float offset)
+{
+    if (!simulationData || table.size() < 2)
+        return;
+
+    // Cells are independent from each other, colors are the opacity-weighted
+    // average of the colors of their primitives
+    ospray::tasking::parallel_for(_cells.size(), [&](const int i) {
+        const auto& cell = _cells[i];
+        ospray::vec3f color(0.f);
+        float opacity = 0.f;
+        size_t nbValues = 0;
+        for (size_t j = cell.begin; j < cell.end; ++j)
+        {
+            if (_offsets[j] >= size)
+                continue;
+            const float value = simulationData[_offsets[j]];
+            if (std::isnan(value))
+                continue;
+            const auto sample =
+                getTransferFunctionValue(table, scale, offset, value);
+            color = color + sample.w * toVec3f(sample);
+            opacity += sample.w;
+            ++nbValues;
+        }
+        _colors[cell.index] =
+            opacity > 0.f ? ospray::vec4f(color.x / opacity, color.y / opacity,
+                                          color.z / opacity,
+                                          opacity / nbValues)
+                          : ospray::vec4f(0.f);
+    });
+}
+
+SimulationGridDescriptor SimulationGrid::getDescriptor() const
+{
+    return {_colors.empty() ? nullptr : _colors.data(), _dimensions, _lower,
+            _cellSize};
+}
+
+void SimulationGrid::_collectGeometries(
+    ospray::Model* model, const ospray::affine3f& transform,
+    std::vector<std::pair<ospray::Geometry*, ospray::affine3f>>& geometries)
+    const
+{
+    if (!model)
+        return;
+
+    for (const auto& geometry : model->geometry)
+    {
+        const auto instance = dynamic_cast<ospray::Instance*>(geometry.ptr);
+        if (instance)
+            _collectGeometries(instance->instancedScene.ptr,
+                               transform * instance->xfm, geometries);
+        else
+            geometries.push_back({geometry.ptr, transform});
+    }
+}
+
+void SimulationGrid::_assignPrimitives(const std::vector<Primitive>& primitives,
+                                       const ospray::uint32 resolution)
+{
+    _cells.clear();
+    _offsets.clear();
+    _colors.clear();
+    _dimensions = ospray::vec3i(0, 0, 0);
+    if (primitives.empty() || resolution == 0)
+        return;
+
+    ospray::vec3f lower = primitives[0].position;
+    ospray::vec3f upper = lower;
+    for (const auto& primitive : primitives)
+    {
+        lower = ospray::min(lower, primitive.position);
+        upper = ospray::max(upper, primitive.position);
+    }
+    const ospray::vec3f extent = upper - lower;
+    const float cellSize =
+        std::max(1e-6f, std::max(extent.x, std::max(extent.y, extent.z)) /
+                            resolution);
+    _lower = lower;
+    _cellSize = ospray::vec3f(cellSize);
+    for (size_t i = 0; i < 3; ++i)
+        _dimensions[i] = std::max(
+            1, std::min(int(resolution), int(std::ceil(extent[i] / cellSize))));
+
+    // Counting sort of the primitives by cell
+    const size_t nbCells =
+        size_t(_dimensions.x) * _dimensions.y * _dimensions.z;
+    std::vector<size_t> cellIndices(primitives.size());
+    std::vector<size_t> cellOffsets(nbCells + 1, 0);
+    for (size_t i = 0; i < primitives.size(); ++i)
+    {
+        const auto p = (primitives[i].position - _lower) / cellSize;
+        const auto x = std::min(size_t(p.x), size_t(_dimensions.x - 1));
+        const auto y = std::min(size_t(p.y), size_t(_dimensions.y - 1));
+        const auto z = std::min(size_t(p.z), size_t(_dimensions.z - 1));
+        cellIndices[i] = x + _dimensions.x * (y + _dimensions.y * z);
+        ++cellOffsets[cellIndices[i] + 1];
+    }
+    for (size_t i = 0; i < nbCells; ++i)
+        cellOffsets[i + 1] += cellOffsets[i];
+
+    _offsets.resize(primitives.size());
+    std::vector<size_t> cursors(cellOffsets.begin(), cellOffsets.end() - 1);
+    for (size_t i = 0; i < primitives.size(); ++i)
+        _offsets[cursors[cellIndices[i]]++] = primitives[i].offset;
+
+    for (size_t i = 0; i < nbCells; ++i)
+        if (cellOffsets[i + 1] > cellOffsets[i])
+            _cells.push_back({i, cellOffsets[i], cellOffsets[i + 1]});
+    _colors.resize(nbCells, ospray::vec4f(0.f));
+}
+} // namespace circuitexplorer
@@ -0,0 +1,101 @@
+/* Copyright (c) 2015-2018, EPFL/Blue Brain Project
+ * All rights reserved. Do not distribute without permission.
+ * Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#pragma once
+
+#include <ospray/SDK/common/Model.h>
+
+#include <vector>
+
+namespace circuitexplorer
+{
+/**
+ * Uniform grid storing, for every cell, the color (xyz) and opacity (w) of the
+ * simulation values of the primitives it contains. Must match the
+ * SimulationGridDescriptor structure of the ISPC renderers
+ */
+struct SimulationGridDescriptor
+{
+    const ospray::vec4f* colors;
+    ospray::vec3i dimensions;
+    ospray::vec3f lower;
+    ospray::vec3f cellSize;
+};
+
+/**
+ * The SimulationGrid class splats the simulation values of the primitives of a
+ * model into a uniform grid. Primitives are only assigned to the cells when
+ * the geometry of the model changes, colors of the cells are computed in
+ * parallel for every simulation frame. Renderers can then ray-march the grid
+ * at a cost bounded by its resolution, whatever the depth complexity of the
+ * model.
+ */
+class SimulationGrid
+{
+public:
+    /**
+     * Assigns the primitives of the model to the cells of the grid, if the
+     * geometry or the resolution changed since the last update
+     * @param resolution Number of cells along the largest side of the grid
+     * @return False if no primitive of the model carries simulation data, or
+     * if the resolution is 0
+     */
+    bool update(ospray::Model* model, const ospray::uint32 resolution);
+
+    /**
+     * Computes the colors of the cells from the simulation values of their
+     * primitives, for the given baked transfer function table
+     */
+    void splat(const float* simulationData, const ospray::uint64 size,
+               const std::vector<ospray::vec4f>& table, const float scale,
+               const float offset);
+
+    SimulationGridDescriptor getDescriptor() const;
+
+private:
+    struct Primitive
+    {
+        ospray::vec3f position;
+        ospray::uint64 offset;
+    };
+
+    struct Cell
+    {
+        size_t index;
+        size_t begin;
+        size_t end;
+    };
+
+    void _collectGeometries(
+        ospray::Model* model, const ospray::affine3f& transform,
+        std::vector<std::pair<ospray::Geometry*, ospray::affine3f>>& geometries)
+        const;
+    void _assignPrimitives(const std::vector<Primitive>& primitives,
+                           const ospray::uint32 resolution);
+
+    std::vector<const void*> _signature;
+    ospray::uint32 _resolution{0};
+
+    ospray::vec3i _dimensions{0, 0, 0};
+    ospray::vec3f _lower{0.f, 0.f, 0.f};
+    ospray::vec3f _cellSize{0.f, 0.f, 0.f};
+    std::vector<Cell> _cells;
+    std::vector<ospray::uint64> _offsets;
+    std::vector<ospray::vec4f> _colors;
+};
+} // namespace circuitexplorer
@@ -0,0 +1,83 @@
+/* Copyright (c) 2015-2018, EPFL/Blue Brain Project
+ * All rights reserved. Do not distribute without permission.
+ * Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "SimulationMapping.h"
+
+#include "../CircuitExplorerMaterial.h"
+
+#include <ospray/SDK/geometry/TriangleMesh.h>
+
+#include <map>
+#include <mutex>
+
+namespace
+{
+std::mutex registryMutex;
+int32_t nextId = 0;
+std::map<int32_t, std::weak_ptr<const circuitexplorer::SimulationMapping>>
+    registry;
+} // namespace
+
+namespace circuitexplorer
+{
+const int32_t SimulationMapping::NO_MAPPING;
+const uint64_t SimulationMapping::UNMAPPED_VERTEX;
+
+SimulationMappingPtr SimulationMapping::create(std::vector<uint64_t>&& offsets)
+{
+    std::lock_guard<std::mutex> lock(registryMutex);
+    const int32_t id = nextId++;
+    SimulationMappingPtr mapping(new SimulationMapping(id, std::move(offsets)));
+    registry[id] = mapping;
+    return mapping;
+}
+
+SimulationMappingPtr SimulationMapping::find(const int32_t id)
+{
+    if (id == NO_MAPPING)
+        return nullptr;
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    const auto it = registry.find(id);
+    return it == registry.end() ? nullptr : it->second.lock();
+}
+
+SimulationMapping::SimulationMapping(const int32_t id,
+                                     std::vector<uint64_t>&& offsets)
+    : _id(id)
+    , _offsets(std::move(offsets))
+{
+}
+
+SimulationMapping::~SimulationMapping()
+{
+    std::lock_guard<std::mutex> lock(registryMutex);
+    registry.erase(_id);
+}
+
+SimulationMappingPtr getSimulationMapping(const ospray::Geometry* geometry)
+{
+    if (!dynamic_cast<const ospray::TriangleMesh*>(geometry))
+        return nullptr;
+
+    // Meshes created by Brayns have a single material
+    const auto material =
+        dynamic_cast<const CircuitExplorerMaterial*>(geometry->material.ptr);
+    return material ? material->simulationMapping : nullptr;
+}
+} // namespace circuitexplorer
@@ -0,0 +1,79 @@
+/* Copyright (c) 2015-2018, EPFL/Blue Brain Project
+ * All rights reserved. Do not distribute without permission.
+ * Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+
+namespace ospray
+{
+struct Geometry;
+}
+
+namespace circuitexplorer
+{
+class SimulationMapping;
+using SimulationMappingPtr = std::shared_ptr<const SimulationMapping>;
+using SimulationMappings = std::vector<SimulationMappingPtr>;
+
+/**
+ * The SimulationMapping class holds the simulation offsets mapped to the
+ * vertices of a mesh, one offset per vertex. Mappings are registered under an
+ * identifier that the circuit loaders store in the simulation mapping property
+ * of the material of the mesh. Materials resolve the identifier when they are
+ * committed, and renderers read the offsets of the intersected vertices
+ * directly. A mapping is unregistered when the last reference to it is
+ * released.
+ */
+class SimulationMapping
+{
+public:
+    /** Identifier of materials that have no simulation mapping */
+    static const int32_t NO_MAPPING = -1;
+
+    /** Offset of the vertices that could not be mapped */
+    static const uint64_t UNMAPPED_VERTEX =
+        std::numeric_limits<uint64_t>::max();
+
+    /** Creates and registers the mapping of the given offsets */
+    static SimulationMappingPtr create(std::vector<uint64_t>&& offsets);
+
+    /** @return The registered mapping with the given identifier, if any */
+    static SimulationMappingPtr find(const int32_t id);
+
+    ~SimulationMapping();
+
+    int32_t getId() const { return _id; }
+    const std::vector<uint64_t>& getOffsets() const { return _offsets; }
+
+private:
+    SimulationMapping(const int32_t id, std::vector<uint64_t>&& offsets);
+
+    const int32_t _id;
+    const std::vector<uint64_t> _offsets;
+};
+
+/**
+ * @return The simulation mapping of the material of a mesh, or nullptr if the
+ * geometry is not a mapped mesh
+ */
+SimulationMappingPtr getSimulationMapping(const ospray::Geometry* geometry);
+} // namespace circuitexplorer
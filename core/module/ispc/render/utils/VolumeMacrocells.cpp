@@ -0,0 +1,145 @@
+/* Copyright (c) 2015-2018, EPFL/Blue Brain Project
+ * All rights reserved. Do not distribute without permission.
+ * Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "VolumeMacrocells.h"
+#include "VolumeMacrocells_ispc.h"
+
+#include <ospray/SDK/common/tasking/parallel_for.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+// Number of voxels along each side of a macrocell
+const int MACROCELL_SIZE = 8;
+} // namespace
+
+namespace circuitexplorer
+{
+bool VolumeMacrocells::update(ospray::Volume* volume,
+                              const std::vector<ospray::vec4f>& table,
+                              const float scale, const float offset)
+{
+    const auto dimensions =
+        volume->getParam3i("dimensions", ospray::vec3i(0, 0, 0));
+    if (dimensions.x < 2 || dimensions.y < 2 || dimensions.z < 2)
+        return false;
+
+    const auto gridOrigin =
+        volume->getParam3f("gridOrigin", ospray::vec3f(0.f, 0.f, 0.f));
+    const auto gridSpacing =
+        volume->getParam3f("gridSpacing", ospray::vec3f(1.f, 1.f, 1.f));
+    if (volume != _volume || dimensions != _dimensions ||
+        gridOrigin != _gridOrigin || gridSpacing != _gridSpacing)
+    {
+        _volume = volume;
+        _dimensions = dimensions;
+        _gridOrigin = gridOrigin;
+        _gridSpacing = gridSpacing;
+        _computeValueRanges(volume);
+        _table.clear();
+    }
+
+    if (table != _table || scale != _scale || offset != _offset)
+        _computeOpacities(table, scale, offset);
+    return true;
+}
+
+VolumeMacrocellGrid VolumeMacrocells::getGrid() const
+{
+    return {_maxOpacity.data(), _nbCells, _gridOrigin,
+            _gridSpacing * float(MACROCELL_SIZE)};
+}
+
+void VolumeMacrocells::_computeValueRanges(ospray::Volume* volume)
+{
+    for (int i = 0; i < 3; ++i)
+        _nbCells[i] = std::max(1, (_dimensions[i] - 2) / MACROCELL_SIZE + 1);
+    const size_t nbCells = size_t(_nbCells.x) * _nbCells.y * _nbCells.z;
+    _minValues.assign(nbCells, std::numeric_limits<float>::max());
+    _maxValues.assign(nbCells, -std::numeric_limits<float>::max());
+
+    // Voxels on the boundary of two macrocells belong to both of them, since
+    // samples taken inside a macrocell interpolate these voxels. Layers of
+    // macrocells are processed in parallel and never share a macrocell.
+    ospray::tasking::parallel_for(_nbCells.z, [&](const int layer) {
+        std::vector<float> values(_dimensions.x);
+        const int firstZ = layer * MACROCELL_SIZE;
+        const int lastZ =
+            std::min(firstZ + MACROCELL_SIZE, _dimensions.z - 1);
+        for (int z = firstZ; z <= lastZ; ++z)
+            for (int y = 0; y < _dimensions.y; ++y)
+            {
+                ispc::VolumeMacrocells_sampleRow(
+                    volume->getIE(), (const ispc::vec3f&)_gridOrigin,
+                    (const ispc::vec3f&)_gridSpacing, y, z, _dimensions.x,
+                    values.data());
+                const int cellY = std::min(y / MACROCELL_SIZE, _nbCells.y - 1);
+                const bool sharedY = (y % MACROCELL_SIZE == 0 && y > 0);
+                for (int x = 0; x < _dimensions.x; ++x)
+                {
+                    const float value = values[x];
+                    const int cellX =
+                        std::min(x / MACROCELL_SIZE, _nbCells.x - 1);
+                    const bool sharedX = (x % MACROCELL_SIZE == 0 && x > 0);
+                    for (int j = sharedY ? -1 : 0; j <= 0; ++j)
+                        for (int i = sharedX ? -1 : 0; i <= 0; ++i)
+                        {
+                            const size_t index =
+                                (size_t(layer) * _nbCells.y + cellY + j) *
+                                    _nbCells.x +
+                                cellX + i;
+                            _minValues[index] =
+                                std::min(_minValues[index], value);
+                            _maxValues[index] =
+                                std::max(_maxValues[index], value);
+                        }
+                }
+            }
+    });
+}
+
+void VolumeMacrocells::_computeOpacities(
+    const std::vector<ospray::vec4f>& table, const float scale,
+    const float offset)
+{
+    _table = table;
+    _scale = scale;
+    _offset = offset;
+
+    const int last = int(_table.size()) - 1;
+    _maxOpacity.resize(_minValues.size());
+    for (size_t i = 0; i < _maxOpacity.size(); ++i)
+    {
+        // Opacities are linearly interpolated between table entries, the
+        // maximum over the value range is reached on one of the entries
+        const int first = int(std::max(
+            0.f, std::min(float(last),
+                          std::floor(_minValues[i] * scale + offset))));
+        const int end = int(std::max(
+            0.f, std::min(float(last),
+                          std::ceil(_maxValues[i] * scale + offset))));
+        float opacity = 0.f;
+        for (int j = first; j <= end; ++j)
+            opacity = std::max(opacity, _table[j].w);
+        _maxOpacity[i] = opacity;
+    }
+}
+} // namespace circuitexplorer
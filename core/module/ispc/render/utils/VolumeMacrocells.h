@@ -0,0 +1,77 @@
+/* Copyright (c) 2015-2018, EPFL/Blue Brain Project
+ * All rights reserved. Do not distribute without permission.
+ * Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#pragma once
+
+#include <ospray/SDK/volume/Volume.h>
+
+#include <vector>
+
+namespace circuitexplorer
+{
+/**
+ * Coarse grid of a volume, storing for every macrocell the maximum opacity
+ * that the transfer function can give to the voxels it contains. Must match
+ * the VolumeMacrocellGrid structure of the ISPC renderers
+ */
+struct VolumeMacrocellGrid
+{
+    const float* maxOpacity;
+    ospray::vec3i nbCells;
+    ospray::vec3f lower;
+    ospray::vec3f cellSize;
+};
+
+/**
+ * The VolumeMacrocells class computes the min/max voxel values of the
+ * macrocells of a structured volume, and the resulting maximum opacities for a
+ * given transfer function. Min/max values are only computed when the volume
+ * changes, opacities only when the transfer function changes.
+ */
+class VolumeMacrocells
+{
+public:
+    /**
+     * Updates the macrocells of the volume for the given baked transfer
+     * function table
+     * @return False if the volume is not a structured volume
+     */
+    bool update(ospray::Volume* volume, const std::vector<ospray::vec4f>& table,
+                const float scale, const float offset);
+
+    VolumeMacrocellGrid getGrid() const;
+
+private:
+    void _computeValueRanges(ospray::Volume* volume);
+    void _computeOpacities(const std::vector<ospray::vec4f>& table,
+                           const float scale, const float offset);
+
+    ospray::Volume* _volume{nullptr};
+    ospray::vec3i _dimensions{0, 0, 0};
+    ospray::vec3f _gridOrigin{0.f, 0.f, 0.f};
+    ospray::vec3f _gridSpacing{0.f, 0.f, 0.f};
+    ospray::vec3i _nbCells{0, 0, 0};
+    std::vector<float> _minValues;
+    std::vector<float> _maxValues;
+
+    std::vector<ospray::vec4f> _table;
+    float _scale{0.f};
+    float _offset{0.f};
+    std::vector<float> _maxOpacity;
+};
+} // namespace circuitexplorer
@@ -20,15 +20,18 @@
 #include <common/CommonTypes.h>
 #include <common/Logs.h>
 
+#include <module/ispc/render/utils/RenderStatistics.h>
 #include <plugin/io/filesystem/BrickLoader.h>
 #ifdef USE_MORPHOLOGIES
 #include <plugin/neuroscience/astrocyte/AstrocyteLoader.h>
 #include <plugin/neuroscience/common/MorphologyLoader.h>
+#include <plugin/neuroscience/common/SimulationFrameCache.h>
 #include <plugin/neuroscience/neuron/AdvancedCircuitLoader.h>
 #include <plugin/neuroscience/neuron/CellGrowthHandler.h>
 #include <plugin/neuroscience/neuron/MeshCircuitLoader.h>
 #include <plugin/neuroscience/neuron/MorphologyCollageLoader.h>
 #include <plugin/neuroscience/neuron/PairSynapsesLoader.h>
+#include <plugin/neuroscience/neuron/SpikeSimulationHandler.h>
 #include <plugin/neuroscience/neuron/SynapseCircuitLoader.h>
 #include <plugin/neuroscience/neuron/VoltageSimulationHandler.h>
 #endif
@@ -123,6 +126,12 @@ void _addAdvancedSimulationRenderer(Engine& engine)
     properties.setProperty({"softShadows", 0., 0., 1., {"Shadow softness"}});
     properties.setProperty(
         {"softShadowsSamples", 1, 1, 64, {"Soft shadow samples"}});
+    properties.setProperty(
+        {"lightSamples",
+         0,
+         0,
+         64,
+         {"Lights picked for shadows per sample (0 for all lights)"}});
     properties.setProperty(
         {"epsilonFactor", 1., 1., 1000., {"Epsilon factor"}});
     properties.setProperty({"samplingThreshold",
@@ -140,6 +149,9 @@ void _addAdvancedSimulationRenderer(Engine& engine)
                             0.001,
                             1.,
                             {"Volume alpha correction"}});
+    properties.setProperty({"volumePreintegration",
+                            false,
+                            {"Preintegrated volume transfer functions"}});
     properties.setProperty({"maxDistanceToSecondaryModel",
                             30.,
                             0.1,
@@ -152,8 +164,26 @@ void _addAdvancedSimulationRenderer(Engine& engine)
         {"maxBounces", 3, 1, 100, {"Maximum number of ray bounces"}});
     properties.setProperty({"useHardwareRandomizer",
                             false,
-                            {"Use hardware accelerated randomizer"}});
+                            {"Use uncorrelated random numbers"}});
     properties.setProperty({"matrixFilter", false, {"Matrix filter"}});
+    properties.setProperty(
+        {"adaptiveSamplingThreshold",
+         0.,
+         0.,
+         1.,
+         {"Pixel noise under which sampling stops (0 to disable)"}});
+    properties.setProperty({"adaptiveSamplingMinSamples",
+                            8,
+                            2,
+                            1024,
+                            {"Minimum samples before a pixel can converge"}});
+    properties.setProperty(
+        {"denoise", false, {"Denoise frames (requires Open Image Denoise)"}});
+    properties.setProperty({"specializedKernels",
+                            true,
+                            {"Use kernels specialized for enabled features"}});
+    properties.setProperty(
+        {"renderStatistics", false, {"Collect render statistics"}});
     engine.addRendererType("circuit_explorer_advanced", properties);
 }
 
@@ -176,7 +206,9 @@ void _addBasicSimulationRenderer(Engine& engine)
         {"maxBounces", 3, 1, 100, {"Maximum number of ray bounces"}});
     properties.setProperty({"useHardwareRandomizer",
                             false,
-                            {"Use hardware accelerated randomizer"}});
+                            {"Use uncorrelated random numbers"}});
+    properties.setProperty(
+        {"renderStatistics", false, {"Collect render statistics"}});
     engine.addRendererType("circuit_explorer_basic", properties);
 }
 
@@ -196,7 +228,14 @@ void _addVoxelizedSimulationRenderer(Engine& engine)
         {"maxBounces", 3, 1, 100, {"Maximum number of ray bounces"}});
     properties.setProperty({"useHardwareRandomizer",
                             false,
-                            {"Use hardware accelerated randomizer"}});
+                            {"Use uncorrelated random numbers"}});
+    properties.setProperty({"gridResolution",
+                            0,
+                            0,
+                            1024,
+                            {"Simulation grid resolution (0 to disable)"}});
+    properties.setProperty(
+        {"renderStatistics", false, {"Collect render statistics"}});
     engine.addRendererType("circuit_explorer_voxelized_simulation", properties);
 }
 
@@ -212,6 +251,11 @@ void _addGrowthRenderer(Engine& engine)
     properties.setProperty({"exposure", 1., 0.01, 10., {"Exposure"}});
     properties.setProperty({"fogStart", 0., 0., 1e6, {"Fog start"}});
     properties.setProperty({"fogThickness", 1e6, 1e6, 1e6, {"Fog thickness"}});
+    properties.setProperty({"growthDistance",
+                            -1.,
+                            -1.,
+                            1e6,
+                            {"Growth distance (-1 to follow animation)"}});
     properties.setProperty({"tfColor", false, {"Use transfer function color"}});
     properties.setProperty({"shadows", 0., 0., 1., {"Shadow intensity"}});
     properties.setProperty({"softShadows", 0., 0., 1., {"Shadow softness"}});
@@ -219,7 +263,9 @@ void _addGrowthRenderer(Engine& engine)
         {"shadowDistance", 1e4, 0., 1e4, {"Shadow distance"}});
     properties.setProperty({"useHardwareRandomizer",
                             false,
-                            {"Use hardware accelerated randomizer"}});
+                            {"Use uncorrelated random numbers"}});
+    properties.setProperty(
+        {"renderStatistics", false, {"Collect render statistics"}});
     engine.addRendererType("circuit_explorer_cell_growth", properties);
 }
 
@@ -242,12 +288,15 @@ void _addProximityRenderer(Engine& engine)
                             {"Detection on different material"}});
     properties.setProperty(
         {"surfaceShadingEnabled", true, {"Surface shading"}});
+    properties.setProperty({"exactDetection", true, {"Exact detection"}});
     properties.setProperty(
         {"maxBounces", 3, 1, 100, {"Maximum number of ray bounces"}});
     properties.setProperty({"exposure", 1., 0.01, 10., {"Exposure"}});
     properties.setProperty({"useHardwareRandomizer",
                             false,
-                            {"Use hardware accelerated randomizer"}});
+                            {"Use uncorrelated random numbers"}});
+    properties.setProperty(
+        {"renderStatistics", false, {"Collect render statistics"}});
     engine.addRendererType("circuit_explorer_proximity_detection", properties);
 }
 
@@ -380,6 +429,11 @@ void CircuitExplorerPlugin::init()
         actionInterface->registerRequest<Response>(endPoint, [&]()
                                                    { return _getVersion(); });
 
+        endPoint = PLUGIN_API_PREFIX + "get-render-statistics";
+        PLUGIN_INFO("Registering '" + endPoint + "' endpoint");
+        actionInterface->registerRequest<RenderStatisticsDescriptor>(
+            endPoint, [&]() { return _getRenderStatistics(); });
+
         endPoint = PLUGIN_API_PREFIX + "set-material";
         PLUGIN_INFO("Registering '" + endPoint + "' endpoint");
         actionInterface->registerNotification<MaterialDescriptor>(
@@ -444,6 +498,41 @@ void CircuitExplorerPlugin::init()
                 endPoint, [&](const AttachCircuitSimulationHandler& s)
                 { _attachCircuitSimulationHandler(s); });
 
+        endPoint = PLUGIN_API_PREFIX + "get-voltage-simulation-statistics";
+        PLUGIN_INFO("Registering '" + endPoint + "' endpoint");
+        actionInterface
+            ->registerRequest<ModelId, VoltageSimulationStatistics>(
+                endPoint,
+                [&](const ModelId& modelId) -> VoltageSimulationStatistics
+                { return _getVoltageSimulationStatistics(modelId); });
+
+        endPoint = PLUGIN_API_PREFIX + "create-voltage-replay-file";
+        PLUGIN_INFO("Registering '" + endPoint + "' endpoint");
+        actionInterface->registerRequest<CreateVoltageReplayFile, Response>(
+            endPoint, [&](const CreateVoltageReplayFile& param) -> Response
+            { return _createVoltageReplayFile(param); });
+
+        endPoint = PLUGIN_API_PREFIX + "get-voltage-replay-file-status";
+        PLUGIN_INFO("Registering '" + endPoint + "' endpoint");
+        actionInterface->registerRequest<VoltageReplayFileStatus>(
+            endPoint, [&]() { return _getVoltageReplayFileStatus(); });
+
+        endPoint = PLUGIN_API_PREFIX + "get-simulation-frame-statistics";
+        PLUGIN_INFO("Registering '" + endPoint + "' endpoint");
+        actionInterface->registerRequest<GetSimulationFrameStatistics,
+                                         SimulationFrameStatisticsDescriptor>(
+            endPoint,
+            [&](const GetSimulationFrameStatistics& param)
+                -> SimulationFrameStatisticsDescriptor
+            { return _getSimulationFrameStatistics(param); });
+
+        endPoint = PLUGIN_API_PREFIX + "set-voltage-replay-file";
+        PLUGIN_INFO("Registering '" + endPoint + "' endpoint");
+        actionInterface->registerRequest<SetVoltageReplayFile, Response>(
+            endPoint,
+            [&](const SetVoltageReplayFile& param) -> Response
+            { return _setVoltageReplayFile(param); });
+
         endPoint = PLUGIN_API_PREFIX + "import-volume";
         PLUGIN_INFO("Registering '" + endPoint + "' endpoint");
         actionInterface->registerRequest<ImportVolume, Response>(
@@ -514,6 +603,9 @@ void CircuitExplorerPlugin::init()
 
 void CircuitExplorerPlugin::preRender()
 {
+#ifdef USE_MORPHOLOGIES
+    _updateVoltageReplayFileTask();
+#endif
     if (_dirty)
     {
         auto& scene = _api->getScene();
@@ -531,6 +623,29 @@ Response CircuitExplorerPlugin::_getVersion() const
     return response;
 }
 
+RenderStatisticsDescriptor CircuitExplorerPlugin::_getRenderStatistics() const
+{
+    const auto statistics = RenderStatisticsCollector::getLastFrameStatistics();
+    RenderStatisticsDescriptor descriptor;
+    descriptor.available = statistics.available;
+    if (!descriptor.available)
+        return descriptor;
+
+    descriptor.renderer = statistics.renderer;
+    descriptor.frameSize = {statistics.frameSize.x, statistics.frameSize.y};
+    descriptor.tileSize = {statistics.tileSize.x, statistics.tileSize.y};
+    descriptor.nbTiles = {statistics.nbTiles.x, statistics.nbTiles.y};
+    descriptor.samples = statistics.counters[counter_samples];
+    descriptor.cycles = statistics.counters[counter_cycles];
+    descriptor.cameraRays = statistics.counters[counter_camera_rays];
+    descriptor.shadowRays = statistics.counters[counter_shadow_rays];
+    descriptor.indirectRays = statistics.counters[counter_indirect_rays];
+    descriptor.simulationRays = statistics.counters[counter_simulation_rays];
+    descriptor.volumeSamples = statistics.counters[counter_volume_samples];
+    descriptor.tileCosts = statistics.tileCosts;
+    return descriptor;
+}
+
 Response CircuitExplorerPlugin::_setMaterialExtraAttributes(
     const MaterialExtraAttributes& details)
 {
@@ -971,9 +1086,13 @@ Response CircuitExplorerPlugin::_attachCircuitSimulationHandler(
                 details.circuitConfiguration);
             const brain::Circuit circuit(blueConfiguration);
             auto gids = circuit.getGIDs();
+            // The frame cache is shared by all handlers, its budget is the
+            // one of the last attached simulation, as with the loaders
+            SimulationFrameCache::getInstance().setBudget(
+                uint64_t(details.frameCacheSize) * 1024 * 1024);
             auto handler = std::make_shared<VoltageSimulationHandler>(
                 blueConfiguration.getReportSource(details.reportName).getPath(),
-                gids, details.synchronousMode);
+                gids, details.synchronousMode, details.prefetchDepth);
             auto& model = modelDescriptor->getModel();
             model.setSimulationHandler(handler);
             AdvancedCircuitLoader::setSimulationTransferFunction(
@@ -986,6 +1105,208 @@ Response CircuitExplorerPlugin::_attachCircuitSimulationHandler(
     CATCH_STD_EXCEPTION()
     return response;
 }
+
+VoltageSimulationStatistics
+    CircuitExplorerPlugin::_getVoltageSimulationStatistics(
+        const ModelId& modelId)
+{
+    VoltageSimulationStatistics statistics;
+    auto& scene = _api->getScene();
+    auto modelDescriptor = scene.getModel(modelId.modelId);
+    if (!modelDescriptor)
+        PLUGIN_THROW("Invalid model ID");
+
+    auto handler = std::dynamic_pointer_cast<VoltageSimulationHandler>(
+        modelDescriptor->getModel().getSimulationHandler());
+    if (!handler)
+        PLUGIN_THROW("Model " + std::to_string(modelId.modelId) +
+                     " has no voltage simulation handler");
+
+    statistics.prefetchDepth = handler->getPrefetchDepth();
+    statistics.nbLoadedFrames = handler->getNbLoadedFrames();
+    statistics.lastFrameWaitTime = handler->getLastFrameWaitTime();
+    statistics.averageFrameWaitTime = handler->getAverageFrameWaitTime();
+    return statistics;
+}
+
+Response CircuitExplorerPlugin::_createVoltageReplayFile(
+    const CreateVoltageReplayFile& payload)
+{
+    Response response;
+    try
+    {
+        if (_replayFileTask.valid())
+            PLUGIN_THROW("A replay file is already being created");
+
+        auto& scene = _api->getScene();
+        auto modelDescriptor = scene.getModel(payload.modelId);
+        if (!modelDescriptor)
+            PLUGIN_THROW("Invalid model ID");
+
+        auto handler = std::dynamic_pointer_cast<VoltageSimulationHandler>(
+            modelDescriptor->getModel().getSimulationHandler());
+        if (!handler)
+            PLUGIN_THROW("Model " + std::to_string(payload.modelId) +
+                         " has no voltage simulation handler");
+
+        // Checked before narrowing, so that values such as 264 are not
+        // silently turned into a valid number of bits
+        if (payload.bitsPerValue != 8 && payload.bitsPerValue != 16)
+            PLUGIN_THROW("Unsupported number of bits per value: " +
+                         std::to_string(payload.bitsPerValue) +
+                         ". Must be 8 or 16");
+
+        // The conversion reads every frame of the report and would block the
+        // server for minutes. It is run in the background, and the replay file
+        // is attached to the handler by _updateVoltageReplayFileTask, on the
+        // main thread, once it is complete
+        _replayFileRequest = payload;
+        _replayFileProgress = 0.f;
+        _replayFileStatus = VoltageReplayFileStatus();
+        _replayFileStatus.running = true;
+        _replayFileTask = std::async(
+            std::launch::async,
+            [this, handler, payload]()
+            {
+                VoltageReplayFileStatus status;
+                try
+                {
+                    const auto error = handler->createReplayFile(
+                        payload.path,
+                        static_cast<uint8_t>(payload.bitsPerValue),
+                        payload.perFrameScaling,
+                        {payload.minValue, payload.maxValue},
+                        [this](const float progress)
+                        { _replayFileProgress = progress; });
+                    status.maxError = error.maxError;
+                    status.rmsError = error.rmsError;
+                }
+                catch (const std::exception& e)
+                {
+                    status.status = false;
+                    status.contents = e.what();
+                }
+                catch (...)
+                {
+                    status.status = false;
+                    status.contents = "Unknown error";
+                }
+                return status;
+            });
+        response.contents = "Creating replay file " + payload.path;
+    }
+    CATCH_STD_EXCEPTION()
+    return response;
+}
+
+VoltageReplayFileStatus CircuitExplorerPlugin::_getVoltageReplayFileStatus()
+{
+    _updateVoltageReplayFileTask();
+    auto status = _replayFileStatus;
+    status.progress = _replayFileProgress;
+    return status;
+}
+
+void CircuitExplorerPlugin::_updateVoltageReplayFileTask()
+{
+    if (!_replayFileTask.valid() ||
+        _replayFileTask.wait_for(std::chrono::milliseconds(0)) !=
+            std::future_status::ready)
+        return;
+
+    _replayFileStatus = _replayFileTask.get();
+    _replayFileStatus.running = false;
+    if (!_replayFileStatus.status)
+    {
+        PLUGIN_ERROR(_replayFileStatus.contents);
+        return;
+    }
+
+    try
+    {
+        auto& scene = _api->getScene();
+        auto modelDescriptor = scene.getModel(_replayFileRequest.modelId);
+        if (!modelDescriptor)
+            PLUGIN_THROW("Model " + std::to_string(_replayFileRequest.modelId) +
+                         " was removed while its replay file was created");
+
+        auto handler = std::dynamic_pointer_cast<VoltageSimulationHandler>(
+            modelDescriptor->getModel().getSimulationHandler());
+        if (!handler)
+            PLUGIN_THROW("Model " + std::to_string(_replayFileRequest.modelId) +
+                         " has no voltage simulation handler");
+
+        handler->setReplayFile(_replayFileRequest.path);
+        scene.markModified();
+    }
+    catch (const std::runtime_error& e)
+    {
+        _replayFileStatus.status = false;
+        _replayFileStatus.contents = e.what();
+        PLUGIN_ERROR(e.what());
+    }
+}
+
+SimulationFrameStatisticsDescriptor
+    CircuitExplorerPlugin::_getSimulationFrameStatistics(
+        const GetSimulationFrameStatistics& payload)
+{
+    auto& scene = _api->getScene();
+    auto modelDescriptor = scene.getModel(payload.modelId);
+    if (!modelDescriptor)
+        PLUGIN_THROW("Invalid model ID");
+
+    SimulationFrameStatistics statistics;
+    SimulationFrameStatisticsDescriptor descriptor;
+    const auto handler = modelDescriptor->getModel().getSimulationHandler();
+    const auto voltageHandler =
+        std::dynamic_pointer_cast<VoltageSimulationHandler>(handler);
+    const auto spikeHandler =
+        std::dynamic_pointer_cast<SpikeSimulationHandler>(handler);
+    if (voltageHandler)
+        descriptor.available =
+            voltageHandler->getFrameStatistics(payload.frame, statistics);
+    else if (spikeHandler)
+        descriptor.available =
+            spikeHandler->getFrameStatistics(payload.frame, statistics);
+    else
+        PLUGIN_THROW("Model " + std::to_string(payload.modelId) +
+                     " has no voltage or spike simulation handler");
+
+    if (descriptor.available)
+    {
+        descriptor.minValue = statistics.minValue;
+        descriptor.maxValue = statistics.maxValue;
+        descriptor.mean = statistics.mean;
+        descriptor.histogram = statistics.histogram;
+    }
+    return descriptor;
+}
+
+Response CircuitExplorerPlugin::_setVoltageReplayFile(
+    const SetVoltageReplayFile& payload)
+{
+    Response response;
+    try
+    {
+        auto& scene = _api->getScene();
+        auto modelDescriptor = scene.getModel(payload.modelId);
+        if (!modelDescriptor)
+            PLUGIN_THROW("Model " + std::to_string(payload.modelId) +
+                         " does not exist");
+
+        auto handler = std::dynamic_pointer_cast<VoltageSimulationHandler>(
+            modelDescriptor->getModel().getSimulationHandler());
+        if (!handler)
+            PLUGIN_THROW("Model " + std::to_string(payload.modelId) +
+                         " has no voltage simulation handler");
+
+        handler->setReplayFile(payload.path);
+        scene.markModified();
+    }
+    CATCH_STD_EXCEPTION()
+    return response;
+}
 #endif
 
 void CircuitExplorerPlugin::_createShapeMaterial(ModelPtr& model,
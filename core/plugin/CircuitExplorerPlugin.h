@@ -21,8 +21,10 @@
 #include <plugin/api/CircuitExplorerParams.h>
 
 #include <array>
+#include <atomic>
 #include <brayns/common/types.h>
 #include <brayns/pluginapi/ExtensionPlugin.h>
+#include <future>
 #include <vector>
 
 namespace circuitexplorer
@@ -50,6 +52,7 @@ public:
 private:
     // Plug-in
     Response _getVersion() const;
+    RenderStatisticsDescriptor _getRenderStatistics() const;
     void _markModified() { _dirty = true; };
 
 #ifdef USE_MORPHOLOGIES
@@ -57,6 +60,14 @@ private:
     Response _attachCellGrowthHandler(const AttachCellGrowthHandler& payload);
     Response _attachCircuitSimulationHandler(
         const AttachCircuitSimulationHandler& payload);
+    VoltageSimulationStatistics _getVoltageSimulationStatistics(
+        const ModelId& modelId);
+    Response _createVoltageReplayFile(const CreateVoltageReplayFile& payload);
+    VoltageReplayFileStatus _getVoltageReplayFileStatus();
+    void _updateVoltageReplayFileTask();
+    Response _setVoltageReplayFile(const SetVoltageReplayFile& payload);
+    SimulationFrameStatisticsDescriptor _getSimulationFrameStatistics(
+        const GetSimulationFrameStatistics& payload);
     Response _setConnectionsPerValue(const ConnectionsPerValue&);
 
     // Database
@@ -67,6 +78,13 @@ private:
     Response _importMorphologyAsSDF(const ImportMorphology&);
 
     SynapseAttributes _synapseAttributes;
+
+    // Creation of voltage replay files. The progress is declared before the
+    // task since the destruction of the task waits for its completion
+    std::atomic<float> _replayFileProgress{0.f};
+    CreateVoltageReplayFile _replayFileRequest;
+    VoltageReplayFileStatus _replayFileStatus;
+    std::future<VoltageReplayFileStatus> _replayFileTask;
 #endif
 
     // Rendering
@@ -40,6 +40,13 @@ namespace api
         throw;                                                               \
     }
 #endif
+// Reads attributes that existing clients may not send, keeping the default
+// value of the parameter when they are missing
+#define OPTIONAL_FROM_JSON(PARAM, JSON, NAME) \
+    if (JSON.find(#NAME) != JSON.end())       \
+    {                                         \
+        FROM_JSON(PARAM, JSON, NAME);         \
+    }
 #define TO_JSON(PARAM, JSON, NAME) JSON[#NAME] = PARAM.NAME
 
 std::string to_json(const Response& param)
@@ -217,6 +224,33 @@ bool from_json(MaterialExtraAttributes& param, const std::string& payload)
     return true;
 }
 
+std::string to_json(const RenderStatisticsDescriptor& param)
+{
+    try
+    {
+        nlohmann::json js;
+        TO_JSON(param, js, available);
+        TO_JSON(param, js, renderer);
+        TO_JSON(param, js, frameSize);
+        TO_JSON(param, js, tileSize);
+        TO_JSON(param, js, nbTiles);
+        TO_JSON(param, js, samples);
+        TO_JSON(param, js, cycles);
+        TO_JSON(param, js, cameraRays);
+        TO_JSON(param, js, shadowRays);
+        TO_JSON(param, js, indirectRays);
+        TO_JSON(param, js, simulationRays);
+        TO_JSON(param, js, volumeSamples);
+        TO_JSON(param, js, tileCosts);
+        return js.dump();
+    }
+    catch (...)
+    {
+        return "";
+    }
+    return "";
+}
+
 #ifdef USE_MORPHOLOGIES
 bool from_json(SynapseAttributes& param, const std::string& payload)
 {
@@ -292,6 +326,115 @@ bool from_json(AttachCircuitSimulationHandler& param,
         FROM_JSON(param, js, circuitConfiguration);
         FROM_JSON(param, js, reportName);
         FROM_JSON(param, js, synchronousMode);
+        OPTIONAL_FROM_JSON(param, js, prefetchDepth);
+        OPTIONAL_FROM_JSON(param, js, frameCacheSize);
+    }
+    catch (...)
+    {
+        return false;
+    }
+    return true;
+}
+
+std::string to_json(const VoltageSimulationStatistics& param)
+{
+    try
+    {
+        nlohmann::json js;
+        TO_JSON(param, js, prefetchDepth);
+        TO_JSON(param, js, nbLoadedFrames);
+        TO_JSON(param, js, lastFrameWaitTime);
+        TO_JSON(param, js, averageFrameWaitTime);
+        return js.dump();
+    }
+    catch (...)
+    {
+        return "";
+    }
+    return "";
+}
+
+bool from_json(CreateVoltageReplayFile& param, const std::string& payload)
+{
+    try
+    {
+        auto js = nlohmann::json::parse(payload);
+        FROM_JSON(param, js, modelId);
+        FROM_JSON(param, js, path);
+        FROM_JSON(param, js, bitsPerValue);
+        FROM_JSON(param, js, perFrameScaling);
+        FROM_JSON(param, js, minValue);
+        FROM_JSON(param, js, maxValue);
+    }
+    catch (...)
+    {
+        return false;
+    }
+    return true;
+}
+
+std::string to_json(const VoltageReplayFileStatus& param)
+{
+    try
+    {
+        nlohmann::json js;
+        TO_JSON(param, js, running);
+        TO_JSON(param, js, progress);
+        TO_JSON(param, js, status);
+        TO_JSON(param, js, contents);
+        TO_JSON(param, js, maxError);
+        TO_JSON(param, js, rmsError);
+        return js.dump();
+    }
+    catch (...)
+    {
+        return "";
+    }
+    return "";
+}
+
+bool from_json(GetSimulationFrameStatistics& param,
+               const std::string& payload)
+{
+    try
+    {
+        auto js = nlohmann::json::parse(payload);
+        FROM_JSON(param, js, modelId);
+        FROM_JSON(param, js, frame);
+    }
+    catch (...)
+    {
+        return false;
+    }
+    return true;
+}
+
+std::string to_json(const SimulationFrameStatisticsDescriptor& param)
+{
+    try
+    {
+        nlohmann::json js;
+        TO_JSON(param, js, available);
+        TO_JSON(param, js, minValue);
+        TO_JSON(param, js, maxValue);
+        TO_JSON(param, js, mean);
+        TO_JSON(param, js, histogram);
+        return js.dump();
+    }
+    catch (...)
+    {
+        return "";
+    }
+    return "";
+}
+
+bool from_json(SetVoltageReplayFile& param, const std::string& payload)
+{
+    try
+    {
+        auto js = nlohmann::json::parse(payload);
+        FROM_JSON(param, js, modelId);
+        FROM_JSON(param, js, path);
     }
     catch (...)
     {
@@ -139,6 +139,25 @@ struct MaterialExtraAttributes
 };
 bool from_json(MaterialExtraAttributes& param, const std::string& payload);
 
+/** Statistics of the last frame rendered with render statistics enabled */
+struct RenderStatisticsDescriptor
+{
+    bool available{false};
+    std::string renderer;
+    std::vector<int32_t> frameSize;
+    std::vector<int32_t> tileSize;
+    std::vector<int32_t> nbTiles;
+    uint64_t samples{0};
+    uint64_t cycles{0};
+    uint64_t cameraRays{0};
+    uint64_t shadowRays{0};
+    uint64_t indirectRays{0};
+    uint64_t simulationRays{0};
+    uint64_t volumeSamples{0};
+    std::vector<uint64_t> tileCosts;
+};
+std::string to_json(const RenderStatisticsDescriptor& param);
+
 #ifdef USE_MORPHOLOGIES
 // Synapse attributes
 struct SynapseAttributes
@@ -187,9 +206,75 @@ struct AttachCircuitSimulationHandler
     std::string circuitConfiguration;
     std::string reportName;
     bool synchronousMode;
+    uint32_t prefetchDepth{2};
+    uint32_t frameCacheSize{1024};
 };
 bool from_json(AttachCircuitSimulationHandler& param,
                const std::string& payload);
+
+/** Frame loading statistics of a voltage simulation handler */
+struct VoltageSimulationStatistics
+{
+    uint32_t prefetchDepth{0};
+    uint64_t nbLoadedFrames{0};
+    double lastFrameWaitTime{0.0};
+    double averageFrameWaitTime{0.0};
+};
+std::string to_json(const VoltageSimulationStatistics& param);
+
+/** Creation of a quantized replay file for a voltage simulation */
+struct CreateVoltageReplayFile
+{
+    uint64_t modelId;
+    std::string path;
+    uint32_t bitsPerValue{16};
+    bool perFrameScaling{false};
+    float minValue{-80.f};
+    float maxValue{-10.f};
+};
+bool from_json(CreateVoltageReplayFile& param, const std::string& payload);
+
+/** Status of the creation of a voltage replay file, run in the background */
+struct VoltageReplayFileStatus
+{
+    bool running{false};
+    float progress{0.f};
+    bool status{true};
+    std::string contents;
+    double maxError{0.0};
+    double rmsError{0.0};
+};
+std::string to_json(const VoltageReplayFileStatus& param);
+
+/**
+ * Statistics of a simulation frame. Statistics are only available for frames
+ * that have already been loaded by the simulation handler.
+ */
+struct GetSimulationFrameStatistics
+{
+    uint64_t modelId;
+    uint32_t frame;
+};
+bool from_json(GetSimulationFrameStatistics& param,
+               const std::string& payload);
+
+struct SimulationFrameStatisticsDescriptor
+{
+    bool available{false};
+    float minValue{0.f};
+    float maxValue{0.f};
+    double mean{0.0};
+    std::vector<uint64_t> histogram;
+};
+std::string to_json(const SimulationFrameStatisticsDescriptor& param);
+
+/** Replay file used by a voltage simulation */
+struct SetVoltageReplayFile
+{
+    uint64_t modelId;
+    std::string path;
+};
+bool from_json(SetVoltageReplayFile& param, const std::string& payload);
 #endif
 
 struct AddGrid
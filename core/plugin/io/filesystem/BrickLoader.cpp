@@ -614,10 +614,16 @@ ModelDescriptorPtr BrickLoader::importFromFile(
             bool synchronized{false};
             file.read((char*)&synchronized, sizeof(bool));
 
+            // Somas only reports are stored in the metadata, since geometry
+            // offsets depend on it
+            const auto it = metadata.find("Somas only report");
+            const bool somasOnly =
+                (it != metadata.end() && stringToEnum<bool>(it->second));
+
             // Handler
-            auto handler =
-                std::make_shared<VoltageSimulationHandler>(reportPath, gids,
-                                                           synchronized);
+            auto handler = std::make_shared<VoltageSimulationHandler>(
+                reportPath, gids, synchronized, DEFAULT_PREFETCH_DEPTH,
+                somasOnly);
             model->setSimulationHandler(handler);
             break;
         }
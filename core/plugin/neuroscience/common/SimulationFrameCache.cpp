@@ -0,0 +1,130 @@
+/* Copyright (c) 2018-2022, EPFL/Blue Brain Project
+ * All rights reserved. Do not distribute without permission.
+ * Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "SimulationFrameCache.h"
+
+#include <common/Logs.h>
+
+namespace circuitexplorer
+{
+namespace neuroscience
+{
+namespace common
+{
+// Number of lookups between two reports of the cache statistics
+const uint64_t STATISTICS_LOG_INTERVAL = 1000;
+
+SimulationFrameCache& SimulationFrameCache::getInstance()
+{
+    static SimulationFrameCache instance;
+    return instance;
+}
+
+void SimulationFrameCache::setBudget(const size_t bytes)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (bytes == _budget)
+        return;
+    _budget = bytes;
+    _evict(0);
+    PLUGIN_INFO("Simulation frame cache budget set to "
+                << _budget / (1024 * 1024) << " MB");
+}
+
+uint64_t SimulationFrameCache::createSourceId()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _nextSourceId++;
+}
+
+FrameBufferPtr SimulationFrameCache::get(const uint64_t sourceId,
+                                         const uint32_t frame)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    FrameBufferPtr data{nullptr};
+    const auto it = _index.find({sourceId, frame});
+    if (it != _index.end())
+    {
+        // Move entry to the front of the list (most recently used)
+        _entries.splice(_entries.begin(), _entries, it->second);
+        data = it->second->data;
+        ++_nbHits;
+    }
+    else
+        ++_nbMisses;
+
+    if ((_nbHits + _nbMisses) % STATISTICS_LOG_INTERVAL == 0)
+        _logStatistics();
+    return data;
+}
+
+void SimulationFrameCache::put(const uint64_t sourceId, const uint32_t frame,
+                               const FrameBufferPtr& data)
+{
+    if (!data)
+        return;
+    const size_t bytes = data->size() * sizeof(float);
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (bytes == 0 || bytes > _budget)
+        return;
+
+    const Key key{sourceId, frame};
+    const auto it = _index.find(key);
+    if (it != _index.end())
+    {
+        _size -= it->second->data->size() * sizeof(float);
+        _entries.erase(it->second);
+        _index.erase(it);
+    }
+
+    _evict(bytes);
+    _entries.push_front({key, data});
+    _index[key] = _entries.begin();
+    _size += bytes;
+}
+
+bool SimulationFrameCache::contains(const uint64_t sourceId,
+                                    const uint32_t frame)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _index.find({sourceId, frame}) != _index.end();
+}
+
+void SimulationFrameCache::_evict(const size_t requiredBytes)
+{
+    while (!_entries.empty() && _size + requiredBytes > _budget)
+    {
+        const auto& entry = _entries.back();
+        _size -= entry.data->size() * sizeof(float);
+        _index.erase(entry.key);
+        _entries.pop_back();
+    }
+}
+
+void SimulationFrameCache::_logStatistics()
+{
+    const auto nbLookups = _nbHits + _nbMisses;
+    PLUGIN_INFO("Simulation frame cache: "
+                << _entries.size() << " frames, " << _size / (1024 * 1024)
+                << "/" << _budget / (1024 * 1024) << " MB, hit rate "
+                << 100.0 * _nbHits / nbLookups << "% (" << _nbHits << "/"
+                << nbLookups << ")");
+}
+} // namespace common
+} // namespace neuroscience
+} // namespace circuitexplorer
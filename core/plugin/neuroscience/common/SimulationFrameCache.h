@@ -0,0 +1,115 @@
+/* Copyright (c) 2018-2022, EPFL/Blue Brain Project
+ * All rights reserved. Do not distribute without permission.
+ * Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#pragma once
+
+#include <brayns/common/types.h>
+
+#include <list>
+#include <map>
+#include <mutex>
+
+namespace circuitexplorer
+{
+namespace neuroscience
+{
+namespace common
+{
+using namespace brayns;
+
+/**
+ * @brief Reference counted simulation frame buffer. Buffers are shared between
+ * the simulation handlers, the frame cache and the renderer, and must
+ * therefore not be modified once they have been handed over.
+ */
+using FrameBufferPtr = std::shared_ptr<floats>;
+
+/**
+ * @brief The SimulationFrameCache class is a least-recently-used cache of
+ * simulation frames, shared by all simulation handlers. Frames are identified
+ * by the source they belong to (one identifier per handler and its clones) and
+ * by their index. The total amount of memory used by the cached frames never
+ * exceeds the budget, least recently used frames being evicted first. The
+ * cache keeps references to the frame buffers, no data is ever copied.
+ */
+class SimulationFrameCache
+{
+public:
+    /**
+     * @brief Returns the cache shared by all simulation handlers
+     */
+    static SimulationFrameCache& getInstance();
+
+    /**
+     * @brief Sets the maximum amount of memory, in bytes, used by the cached
+     * frames. A budget of zero disables the cache.
+     */
+    void setBudget(const size_t bytes);
+    size_t getBudget() const { return _budget; }
+
+    /**
+     * @brief Returns a new identifier for a source of simulation frames
+     */
+    uint64_t createSourceId();
+
+    /**
+     * @brief Returns a cached frame
+     * @return The frame buffer, or nullptr if the frame is not in the cache
+     */
+    FrameBufferPtr get(const uint64_t sourceId, const uint32_t frame);
+
+    /**
+     * @brief Stores a frame in the cache, evicting the least recently used
+     * frames if the budget is exceeded
+     */
+    void put(const uint64_t sourceId, const uint32_t frame,
+             const FrameBufferPtr& data);
+
+    /**
+     * @brief Returns true if the frame is in the cache. This does not affect
+     * the statistics nor the eviction order.
+     */
+    bool contains(const uint64_t sourceId, const uint32_t frame);
+
+private:
+    SimulationFrameCache() = default;
+
+    using Key = std::pair<uint64_t, uint32_t>;
+    struct Entry
+    {
+        Key key;
+        FrameBufferPtr data;
+    };
+    using Entries = std::list<Entry>;
+
+    void _evict(const size_t requiredBytes);
+    void _logStatistics();
+
+    std::mutex _mutex;
+    Entries _entries; // Most recently used first
+    std::map<Key, Entries::iterator> _index;
+    size_t _budget{1024ull * 1024ull * 1024ull};
+    size_t _size{0};
+    uint64_t _nextSourceId{0};
+
+    uint64_t _nbHits{0};
+    uint64_t _nbMisses{0};
+};
+} // namespace common
+} // namespace neuroscience
+} // namespace circuitexplorer
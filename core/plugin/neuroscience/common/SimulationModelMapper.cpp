@@ -0,0 +1,262 @@
+/* Copyright (c) 2018-2022, EPFL/Blue Brain Project
+ * All rights reserved. Do not distribute without permission.
+ * Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "SimulationModelMapper.h"
+
+#include <common/Logs.h>
+#include <common/Types.h>
+
+#include <brayns/common/Timer.h>
+#include <brayns/engineapi/Material.h>
+#include <brayns/engineapi/Model.h>
+
+namespace circuitexplorer
+{
+namespace neuroscience
+{
+namespace common
+{
+namespace
+{
+// Maximum number of grid cells along each axis
+const uint32_t MAX_GRID_RESOLUTION = 128;
+
+/** Spheres, cylinders and cones are all handled as (capped) cones */
+struct SimulationPrimitive
+{
+    Vector3f p0;
+    Vector3f p1;
+    float r0;
+    float r1;
+    uint64_t offset;
+};
+
+float distanceToPrimitive(const Vector3f& point,
+                          const SimulationPrimitive& primitive)
+{
+    const Vector3f axis = primitive.p1 - primitive.p0;
+    const float length2 = glm::dot(axis, axis);
+    float t = 0.f;
+    if (length2 > 0.f)
+        t = glm::clamp(glm::dot(point - primitive.p0, axis) / length2, 0.f,
+                       1.f);
+    const Vector3f projection = primitive.p0 + t * axis;
+    const float radius = primitive.r0 + t * (primitive.r1 - primitive.r0);
+    return std::max(0.f, glm::length(point - projection) - radius);
+}
+
+/**
+ * Uniform grid storing, in a compressed row layout, the indices of the
+ * primitives overlapping each cell
+ */
+class SimulationPrimitiveGrid
+{
+public:
+    SimulationPrimitiveGrid(const std::vector<SimulationPrimitive>& primitives,
+                            const float maxDistance)
+        : _primitives(primitives)
+    {
+        for (const auto& primitive : _primitives)
+        {
+            const auto bounds = _getBounds(primitive);
+            _bounds.merge(bounds.getMin());
+            _bounds.merge(bounds.getMax());
+        }
+        const Vector3f extent = _bounds.getSize();
+        const float maxExtent =
+            std::max(extent.x, std::max(extent.y, extent.z));
+        _cellSize = std::max(std::max(maxDistance, 1e-3f),
+                             maxExtent / MAX_GRID_RESOLUTION);
+        for (size_t i = 0; i < 3; ++i)
+            _resolution[i] = uint32_t(extent[i] / _cellSize) + 1;
+
+        // Count primitives per cell, then fill the cells
+        const size_t nbCells = size_t(_resolution.x) * _resolution.y *
+                               _resolution.z;
+        _cellOffsets.resize(nbCells + 1, 0);
+        _forEachCell(
+            [this](const size_t cell, const uint32_t)
+            { ++_cellOffsets[cell + 1]; });
+        for (size_t i = 0; i < nbCells; ++i)
+            _cellOffsets[i + 1] += _cellOffsets[i];
+        _cellPrimitives.resize(_cellOffsets[nbCells]);
+        std::vector<uint32_t> cursors(_cellOffsets.begin(),
+                                      _cellOffsets.end() - 1);
+        _forEachCell(
+            [this, &cursors](const size_t cell, const uint32_t primitive)
+            { _cellPrimitives[cursors[cell]++] = primitive; });
+    }
+
+    /**
+     * Returns the index of the closest primitive within maxDistance of the
+     * point, or -1 if there is none
+     */
+    int64_t findClosest(const Vector3f& point, const float maxDistance) const
+    {
+        const auto minCell = _getCell(point - Vector3f(maxDistance));
+        const auto maxCell = _getCell(point + Vector3f(maxDistance));
+
+        int64_t closest = -1;
+        float closestDistance = maxDistance;
+        for (int32_t z = minCell.z; z <= maxCell.z; ++z)
+            for (int32_t y = minCell.y; y <= maxCell.y; ++y)
+                for (int32_t x = minCell.x; x <= maxCell.x; ++x)
+                {
+                    const size_t cell = _getCellIndex(x, y, z);
+                    for (uint32_t i = _cellOffsets[cell];
+                         i < _cellOffsets[cell + 1]; ++i)
+                    {
+                        const auto index = _cellPrimitives[i];
+                        const float distance =
+                            distanceToPrimitive(point, _primitives[index]);
+                        if (distance <= closestDistance)
+                        {
+                            closestDistance = distance;
+                            closest = index;
+                        }
+                    }
+                }
+        return closest;
+    }
+
+private:
+    Boxf _getBounds(const SimulationPrimitive& primitive) const
+    {
+        const float radius = std::max(primitive.r0, primitive.r1);
+        Boxf bounds;
+        bounds.merge(glm::min(primitive.p0, primitive.p1) - Vector3f(radius));
+        bounds.merge(glm::max(primitive.p0, primitive.p1) + Vector3f(radius));
+        return bounds;
+    }
+
+    Vector3i _getCell(const Vector3f& point) const
+    {
+        Vector3i cell;
+        for (size_t i = 0; i < 3; ++i)
+            cell[i] = glm::clamp(int32_t((point[i] - _bounds.getMin()[i]) /
+                                         _cellSize),
+                                 0, int32_t(_resolution[i]) - 1);
+        return cell;
+    }
+
+    size_t _getCellIndex(const int32_t x, const int32_t y,
+                         const int32_t z) const
+    {
+        return (size_t(z) * _resolution.y + y) * _resolution.x + x;
+    }
+
+    template <typename F>
+    void _forEachCell(F func) const
+    {
+        for (uint32_t i = 0; i < _primitives.size(); ++i)
+        {
+            const auto bounds = _getBounds(_primitives[i]);
+            const auto minCell = _getCell(bounds.getMin());
+            const auto maxCell = _getCell(bounds.getMax());
+            for (int32_t z = minCell.z; z <= maxCell.z; ++z)
+                for (int32_t y = minCell.y; y <= maxCell.y; ++y)
+                    for (int32_t x = minCell.x; x <= maxCell.x; ++x)
+                        func(_getCellIndex(x, y, z), i);
+        }
+    }
+
+    const std::vector<SimulationPrimitive>& _primitives;
+    Boxf _bounds;
+    float _cellSize{1.f};
+    Vector3ui _resolution;
+    std::vector<uint32_t> _cellOffsets;
+    std::vector<uint32_t> _cellPrimitives;
+};
+} // namespace
+
+SimulationMappings SimulationModelMapper::mapMeshes(Model& model,
+                                                    const float maxDistance)
+{
+    Timer chrono;
+    std::vector<SimulationPrimitive> primitives;
+    const auto spheres = model.getSpheres().find(SECONDARY_MODEL_MATERIAL_ID);
+    if (spheres != model.getSpheres().end())
+        for (const auto& sphere : spheres->second)
+            primitives.push_back({sphere.center, sphere.center, sphere.radius,
+                                  sphere.radius, sphere.userData});
+    const auto cylinders =
+        model.getCylinders().find(SECONDARY_MODEL_MATERIAL_ID);
+    if (cylinders != model.getCylinders().end())
+        for (const auto& cylinder : cylinders->second)
+            primitives.push_back({cylinder.center, cylinder.up,
+                                  cylinder.radius, cylinder.radius,
+                                  cylinder.userData});
+    const auto cones = model.getCones().find(SECONDARY_MODEL_MATERIAL_ID);
+    if (cones != model.getCones().end())
+        for (const auto& cone : cones->second)
+            primitives.push_back({cone.center, cone.up, cone.centerRadius,
+                                  cone.upRadius, cone.userData});
+    if (primitives.empty())
+    {
+        PLUGIN_INFO("No simulation primitive to map meshes to");
+        return {};
+    }
+
+    const SimulationPrimitiveGrid grid(primitives, maxDistance);
+    SimulationMappings mappings;
+    size_t nbMappedVertices = 0;
+    size_t nbVertices = 0;
+    for (const auto& meshes : model.getTriangleMeshes())
+    {
+        if (meshes.first == SECONDARY_MODEL_MATERIAL_ID)
+            continue;
+
+        const auto& mesh = meshes.second;
+        const int64_t nbMeshVertices = mesh.vertices.size();
+        std::vector<uint64_t> offsets(nbMeshVertices,
+                                      SimulationMapping::UNMAPPED_VERTEX);
+        size_t nbMeshMappedVertices = 0;
+#pragma omp parallel for reduction(+ : nbMeshMappedVertices)
+        for (int64_t i = 0; i < nbMeshVertices; ++i)
+        {
+            const auto closest =
+                grid.findClosest(mesh.vertices[i], maxDistance);
+            if (closest >= 0)
+            {
+                offsets[i] = primitives[closest].offset;
+                ++nbMeshMappedVertices;
+            }
+        }
+        nbMappedVertices += nbMeshMappedVertices;
+        nbVertices += nbMeshVertices;
+        if (nbMeshMappedVertices == 0)
+            continue;
+
+        // The material tells the renderers which mapping the mesh uses
+        const auto mapping = SimulationMapping::create(std::move(offsets));
+        PropertyMap props;
+        props.setProperty(
+            {MATERIAL_PROPERTY_SIMULATION_MAPPING, int(mapping->getId())});
+        model.getMaterial(meshes.first)->updateProperties(props);
+        mappings.push_back(mapping);
+    }
+    PLUGIN_TIMER(chrono.elapsed(), "Mapped " << nbMappedVertices << "/"
+                                             << nbVertices
+                                             << " mesh vertices to "
+                                             << primitives.size()
+                                             << " simulation primitives");
+    return mappings;
+}
+} // namespace common
+} // namespace neuroscience
+} // namespace circuitexplorer
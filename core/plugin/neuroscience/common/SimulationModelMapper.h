@@ -0,0 +1,61 @@
+/* Copyright (c) 2018-2022, EPFL/Blue Brain Project
+ * All rights reserved. Do not distribute without permission.
+ * Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#pragma once
+
+#include <module/ispc/render/utils/SimulationMapping.h>
+
+#include <brayns/common/types.h>
+
+namespace circuitexplorer
+{
+namespace neuroscience
+{
+namespace common
+{
+using namespace brayns;
+
+/**
+ * @brief The SimulationModelMapper class maps the vertices of the meshes of a
+ * model to the simulation primitives (spheres, cylinders and cones) of its
+ * secondary model. Simulation primitives are indexed in a uniform grid, and
+ * each vertex is assigned the simulation offset of the closest primitive found
+ * within the maximum distance. Offsets are stored in a simulation mapping per
+ * mesh, whose identifier is set in the simulation mapping property of the
+ * material of the mesh, so that the renderers can shade a mesh with a single
+ * lookup instead of casting a ray towards the secondary model. Texture
+ * coordinates of the meshes are left untouched.
+ */
+class SimulationModelMapper
+{
+public:
+    /**
+     * @brief Maps the meshes of the model to its secondary model, and sets the
+     * simulation mapping property of the materials of the mapped meshes
+     * @param model Model containing both the meshes and the secondary model
+     * @param maxDistance Maximum distance between a vertex and the surface of
+     * the simulation primitive it is mapped to
+     * @return The mappings of the meshes. Mappings are released, and the
+     * meshes revert to unmapped ones, when the last reference to them is
+     * released
+     */
+    static SimulationMappings mapMeshes(Model& model, const float maxDistance);
+};
+} // namespace common
+} // namespace neuroscience
+} // namespace circuitexplorer
@@ -0,0 +1,151 @@
+/* Copyright (c) 2018-2022, EPFL/Blue Brain Project
+ * All rights reserved. Do not distribute without permission.
+ * Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "SimulationStatisticsCollector.h"
+
+#include <common/Logs.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace circuitexplorer
+{
+namespace neuroscience
+{
+namespace common
+{
+// Pending frames are dropped, oldest first, when the background thread cannot
+// keep up with the playback
+const size_t MAX_PENDING_FRAMES = 16;
+
+// Maximum number of frames for which statistics are kept
+const size_t MAX_FRAME_STATISTICS = 100000;
+
+SimulationStatisticsCollector::SimulationStatisticsCollector(
+    const size_t nbBins)
+    : _nbBins(std::max(size_t(1), nbBins))
+    , _thread(&SimulationStatisticsCollector::_run, this)
+{
+}
+
+SimulationStatisticsCollector::~SimulationStatisticsCollector()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _condition.notify_one();
+    _thread.join();
+}
+
+void SimulationStatisticsCollector::submit(const uint32_t frame,
+                                           const FrameBufferPtr& data)
+{
+    if (!data || data->empty())
+        return;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_statistics.find(frame) != _statistics.end())
+            return;
+        for (const auto& pending : _queue)
+            if (pending.first == frame)
+                return;
+        if (_queue.size() >= MAX_PENDING_FRAMES)
+            _queue.pop_front();
+        _queue.push_back({frame, data});
+    }
+    _condition.notify_one();
+}
+
+bool SimulationStatisticsCollector::getStatistics(
+    const uint32_t frame, SimulationFrameStatistics& statistics)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    const auto it = _statistics.find(frame);
+    if (it == _statistics.end())
+        return false;
+    statistics = it->second;
+    return true;
+}
+
+void SimulationStatisticsCollector::_run()
+{
+    while (true)
+    {
+        std::pair<uint32_t, FrameBufferPtr> pending;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _condition.wait(lock, [this] { return _stop || !_queue.empty(); });
+            if (_stop)
+                return;
+            pending = std::move(_queue.front());
+            _queue.pop_front();
+        }
+
+        const auto statistics = _computeStatistics(*pending.second);
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_statistics.size() >= MAX_FRAME_STATISTICS)
+            _statistics.erase(_statistics.begin());
+        _statistics[pending.first] = statistics;
+    }
+}
+
+SimulationFrameStatistics SimulationStatisticsCollector::_computeStatistics(
+    const floats& data) const
+{
+    SimulationFrameStatistics statistics;
+    statistics.minValue = std::numeric_limits<float>::max();
+    statistics.maxValue = -std::numeric_limits<float>::max();
+    double sum = 0.0;
+    size_t nbValues = 0;
+    for (const auto value : data)
+    {
+        // Missing values (NaN) are ignored
+        if (std::isnan(value))
+            continue;
+        statistics.minValue = std::min(statistics.minValue, value);
+        statistics.maxValue = std::max(statistics.maxValue, value);
+        sum += value;
+        ++nbValues;
+    }
+    statistics.histogram.resize(_nbBins, 0);
+    if (nbValues == 0)
+    {
+        statistics.minValue = statistics.maxValue = 0.f;
+        return statistics;
+    }
+    statistics.mean = sum / nbValues;
+
+    const float range = statistics.maxValue - statistics.minValue;
+    const float scale = (range > 0.f ? _nbBins / range : 0.f);
+    for (const auto value : data)
+    {
+        if (std::isnan(value))
+            continue;
+        const size_t bin = std::min(
+            _nbBins - 1,
+            static_cast<size_t>((value - statistics.minValue) * scale));
+        ++statistics.histogram[bin];
+    }
+    return statistics;
+}
+} // namespace common
+} // namespace neuroscience
+} // namespace circuitexplorer
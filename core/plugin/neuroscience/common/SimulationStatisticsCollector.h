@@ -0,0 +1,98 @@
+/* Copyright (c) 2018-2022, EPFL/Blue Brain Project
+ * All rights reserved. Do not distribute without permission.
+ * Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#pragma once
+
+#include "SimulationFrameCache.h"
+
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace circuitexplorer
+{
+namespace neuroscience
+{
+namespace common
+{
+using namespace brayns;
+
+/**
+ * @brief Statistics of the values of a simulation frame
+ */
+struct SimulationFrameStatistics
+{
+    float minValue{0.f};
+    float maxValue{0.f};
+    double mean{0.0};
+    // Number of values per bin, bins being evenly distributed between the
+    // minimum and the maximum values
+    std::vector<uint64_t> histogram;
+};
+
+/**
+ * @brief The SimulationStatisticsCollector class computes statistics of
+ * simulation frames in a background thread, so that playback is not slowed
+ * down. Frames are submitted by the simulation handlers once they are ready,
+ * and statistics can be queried at any time. Since frame buffers are reference
+ * counted and immutable, frames are not copied.
+ *
+ * Only frames loaded by the handlers (visited or prefetched by the playback)
+ * are covered, the simulation is never read for the sole purpose of computing
+ * statistics. A single thread processes the frames, and the oldest pending
+ * frames are dropped when it cannot keep up with the playback.
+ */
+class SimulationStatisticsCollector
+{
+public:
+    SimulationStatisticsCollector(const size_t nbBins = 64);
+    ~SimulationStatisticsCollector();
+
+    /**
+     * @brief Queues a frame for statistics computation. Frames for which
+     * statistics are already available are ignored.
+     */
+    void submit(const uint32_t frame, const FrameBufferPtr& data);
+
+    /**
+     * @brief Returns the statistics of a frame
+     * @return True if the statistics of the frame are available
+     */
+    bool getStatistics(const uint32_t frame,
+                       SimulationFrameStatistics& statistics);
+
+private:
+    void _run();
+    SimulationFrameStatistics _computeStatistics(const floats& data) const;
+
+    const size_t _nbBins;
+
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    std::deque<std::pair<uint32_t, FrameBufferPtr>> _queue;
+    std::map<uint32_t, SimulationFrameStatistics> _statistics;
+    bool _stop{false};
+    std::thread _thread;
+};
+using SimulationStatisticsCollectorPtr =
+    std::shared_ptr<SimulationStatisticsCollector>;
+} // namespace common
+} // namespace neuroscience
+} // namespace circuitexplorer
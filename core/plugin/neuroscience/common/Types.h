@@ -254,6 +254,18 @@ const brayns::Property PROP_USER_DATA_TYPE = {
 const brayns::Property PROP_SYNCHRONOUS_MODE = {"023SynchronousMode",
                                                 false,
                                                 {"Synchronous mode"}};
+const brayns::Property PROP_PREFETCH_DEPTH = {
+    "024PrefetchDepth",
+    2,
+    {"Number of simulation frames loaded ahead of playback"}};
+const brayns::Property PROP_FRAME_CACHE_SIZE = {
+    "025FrameCacheSize",
+    1024,
+    {"Memory budget of the simulation frame cache [MB]"}};
+const brayns::Property PROP_REPLAY_FILE = {
+    "026ReplayFile",
+    std::string(),
+    {"Quantized replay file used instead of the compartment report"}};
 const brayns::Property PROP_CIRCUIT_COLOR_SCHEME = {
     "030CircuitColorScheme",
     enumToString(CircuitColorScheme::none),
@@ -268,6 +280,10 @@ const brayns::Property PROP_MESH_FILENAME_PATTERN = {
     {"File name pattern for meshes"}};
 const brayns::Property PROP_MESH_TRANSFORMATION = {
     "042MeshTransformation", false, {"Apply circuit transformation to meshes"}};
+const brayns::Property PROP_MAX_DISTANCE_TO_SIMULATION_MODEL = {
+    "043MaxDistanceToSimulationModel",
+    30.0,
+    {"Maximum distance between meshes and simulation (0 to disable mapping)"}};
 const brayns::Property PROP_SECTION_TYPE_SOMA = {"052SectionTypeSoma",
                                                  true,
                                                  {"Soma"}};
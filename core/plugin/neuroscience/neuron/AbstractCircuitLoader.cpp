@@ -23,6 +23,8 @@
 
 #include <plugin/neuroscience/common/MorphologyLoader.h>
 #include <plugin/neuroscience/common/ParallelModelContainer.h>
+#include <plugin/neuroscience/common/SimulationFrameCache.h>
+#include <plugin/neuroscience/common/SimulationModelMapper.h>
 #include <plugin/neuroscience/common/Types.h>
 
 #include <common/CommonTypes.h>
@@ -198,7 +200,8 @@ brain::GIDSet AbstractCircuitLoader::_getGids(
 
 CompartmentReportPtr AbstractCircuitLoader::_attachSimulationHandler(
     const PropertyMap &properties, const brion::BlueConfig &blueConfiguration,
-    Model &model, const ReportType &reportType, brain::GIDSet &gids) const
+    Model &model, const ReportType &reportType, brain::GIDSet &gids,
+    const bool somasOnly) const
 {
     CompartmentReportPtr compartmentReport{nullptr};
 
@@ -215,6 +218,12 @@ CompartmentReportPtr AbstractCircuitLoader::_attachSimulationHandler(
         properties.getProperty<std::string>(PROP_DB_CONNECTION_STRING.name);
     const auto synchronousMode =
         !properties.getProperty<bool>(PROP_SYNCHRONOUS_MODE.name);
+    const auto prefetchDepth = std::max(
+        0, properties.getProperty<int>(PROP_PREFETCH_DEPTH.name));
+    const size_t frameCacheSize = std::max(
+        0, properties.getProperty<int>(PROP_FRAME_CACHE_SIZE.name));
+    SimulationFrameCache::getInstance().setBudget(frameCacheSize * 1024 *
+                                                  1024);
 
     AbstractSimulationHandlerPtr simulationHandler{nullptr};
     switch (reportType)
@@ -225,9 +234,13 @@ CompartmentReportPtr AbstractCircuitLoader::_attachSimulationHandler(
                     << (synchronousMode ? "a" : "") << "synchronous mode");
         const auto &voltageReport = blueConfiguration.getReportSource(report);
         PLUGIN_INFO("Voltage report: " << voltageReport);
-        auto handler =
-            std::make_shared<VoltageSimulationHandler>(voltageReport.getPath(),
-                                                       gids, synchronousMode);
+        auto handler = std::make_shared<VoltageSimulationHandler>(
+            voltageReport.getPath(), gids, synchronousMode, prefetchDepth,
+            somasOnly);
+        const auto replayFile =
+            properties.getProperty<std::string>(PROP_REPLAY_FILE.name);
+        if (!replayFile.empty())
+            handler->setReplayFile(replayFile);
         compartmentReport = handler->getReport();
 
         // Only keep simulated GIDs
@@ -363,6 +376,14 @@ ModelDescriptorPtr AbstractCircuitLoader::importCircuit(
     const auto areasOfInterest =
         properties.getProperty<int>(PROP_AREAS_OF_INTEREST.name);
 
+    // Cells loaded as somas only, and the somas-only mode of the voltage
+    // simulation handler, must be decided from the same properties
+    const auto sectionTypes =
+        MorphologyLoader::getSectionTypesFromProperties(properties);
+    const bool somasOnly =
+        (sectionTypes.size() == 1 &&
+         sectionTypes[0] == brain::neuron::SectionType::soma);
+
     // Model (one for the whole circuit)
     auto model = _scene.createModel();
     if (!model)
@@ -384,7 +405,7 @@ ModelDescriptorPtr AbstractCircuitLoader::importCircuit(
     PLUGIN_INFO("- Attaching simulation handler");
     const auto compartmentReport =
         _attachSimulationHandler(properties, blueConfiguration, *model,
-                                 reportType, allGids);
+                                 reportType, allGids, somasOnly);
 
     PLUGIN_INFO("- Applying cell transformations");
     Matrix4fs allTransformations;
@@ -427,7 +448,7 @@ ModelDescriptorPtr AbstractCircuitLoader::importCircuit(
             _importMorphologies(properties, circuit, *model, allGids,
                                 allTransformations, targetGIDOffsets,
                                 compartmentReport, layerIds, morphologyTypes,
-                                electrophysiologyTypes, callback);
+                                electrophysiologyTypes, somasOnly, callback);
     else
     {
         PLUGIN_INFO("- Importing meshes");
@@ -436,6 +457,7 @@ ModelDescriptorPtr AbstractCircuitLoader::importCircuit(
                       electrophysiologyTypes, callback);
 
         if (compartmentReport != nullptr)
+        {
             // If meshes are loaded, and simulation is enabled, a secondary
             // model is created to store the simulation data in the 3D scene
             maxMorphologyLength =
@@ -443,7 +465,30 @@ ModelDescriptorPtr AbstractCircuitLoader::importCircuit(
                                     allTransformations, targetGIDOffsets,
                                     compartmentReport, layerIds,
                                     morphologyTypes, electrophysiologyTypes,
-                                    callback, SECONDARY_MODEL_MATERIAL_ID);
+                                    somasOnly, callback,
+                                    SECONDARY_MODEL_MATERIAL_ID);
+
+            // Mesh vertices are mapped to the secondary model once and for
+            // all, sparing the renderers a ray per intersection
+            const auto maxDistance = properties.getProperty<double>(
+                PROP_MAX_DISTANCE_TO_SIMULATION_MODEL.name,
+                PROP_MAX_DISTANCE_TO_SIMULATION_MODEL.get<double>());
+            if (maxDistance > 0.0)
+            {
+                callback.updateProgress("Mapping meshes to simulation...", 1);
+                PLUGIN_INFO("- Mapping meshes to simulation model");
+                const auto mappings =
+                    SimulationModelMapper::mapMeshes(*model, maxDistance);
+
+                // Mappings follow the lifetime of the report they were
+                // computed for
+                const auto voltageHandler =
+                    std::dynamic_pointer_cast<VoltageSimulationHandler>(
+                        model->getSimulationHandler());
+                if (voltageHandler)
+                    voltageHandler->setSimulationMappings(mappings);
+            }
+        }
     }
 
     if (userDataType == UserDataType::distance_to_soma)
@@ -476,6 +521,11 @@ ModelDescriptorPtr AbstractCircuitLoader::importCircuit(
         circuitCenter.merge(get_translation(transformation));
 
     PLUGIN_INFO("- Creating final 3D model");
+    const auto voltageHandler =
+        std::dynamic_pointer_cast<VoltageSimulationHandler>(
+            model->getSimulationHandler());
+    const bool somasOnlyReport =
+        (voltageHandler && voltageHandler->isSomasOnly());
     ModelMetadata metadata = {
         {"Report", properties.getProperty<std::string>(PROP_REPORT.name)},
         {"Report type",
@@ -492,6 +542,7 @@ ModelDescriptorPtr AbstractCircuitLoader::importCircuit(
          std::to_string(properties.getProperty<double>(PROP_DENSITY.name))},
         {"RandomSeed",
          std::to_string(properties.getProperty<double>(PROP_RANDOM_SEED.name))},
+        {"Somas only report", enumToString<bool>(somasOnlyReport)},
         {"CircuitPath", circuitConfiguration}};
 
     ModelDescriptorPtr modelDescriptor;
@@ -859,8 +910,8 @@ float AbstractCircuitLoader::_importMorphologies(
     const brain::GIDSet &gids, const Matrix4fs &transformations,
     const GIDOffsets &targetGIDOffsets, CompartmentReportPtr compartmentReport,
     const size_ts &layerIds, const size_ts &morphologyTypes,
-    const size_ts &electrophysiologyTypes, const LoaderProgress &callback,
-    const size_t materialId) const
+    const size_ts &electrophysiologyTypes, const bool somasOnly,
+    const LoaderProgress &callback, const size_t materialId) const
 {
     const auto preSynapticNeuron =
         properties.getProperty<std::string>(PROP_PRESYNAPTIC_NEURON_GID.name);
@@ -873,13 +924,45 @@ float AbstractCircuitLoader::_importMorphologies(
     const bool loadEfferentSynapses =
         properties.getProperty<bool>(PROP_LOAD_EFFERENT_SYNAPSES.name);
 
-    Timer chrono;
-    const auto sectionTypes =
-        MorphologyLoader::getSectionTypesFromProperties(_defaults);
-    const bool somasOnly =
-        (sectionTypes.size() == 1 &&
-         sectionTypes[0] == brain::neuron::SectionType::soma);
+    PropertyMap morphologyProps(properties);
+
+    std::vector<Gid> localGids;
+    for (const auto gid : gids)
+        localGids.push_back(gid);
 
+    // Frames of somas-only voltage reports contain one value per cell, in the
+    // order of the GIDs of the report. Clipping planes and areas of interest
+    // remove cells, so the loading index of a cell may differ from its
+    // position in the report. Cells are mapped to the simulation buffer using
+    // that position, as if there was no compartment report.
+    uint64_ts somaOffsets;
+    const auto voltageHandler =
+        std::dynamic_pointer_cast<VoltageSimulationHandler>(
+            model.getSimulationHandler());
+    if (somasOnly && compartmentReport && voltageHandler &&
+        voltageHandler->isSomasOnly())
+    {
+        // Both GID sets are sorted, the report one containing the other
+        const auto &reportGids = compartmentReport->getGIDs();
+        auto reportGid = reportGids.begin();
+        uint64_t position = 0;
+        somaOffsets.reserve(localGids.size());
+        for (const auto gid : localGids)
+        {
+            while (reportGid != reportGids.end() && *reportGid < gid)
+            {
+                ++reportGid;
+                ++position;
+            }
+            if (reportGid == reportGids.end() || *reportGid != gid)
+                PLUGIN_THROW("Cell " + std::to_string(gid) +
+                             " is not part of the voltage report");
+            somaOffsets.push_back(position);
+        }
+        compartmentReport = nullptr;
+    }
+
+    Timer chrono;
     brain::URIs uris;
     if (!somasOnly)
     {
@@ -887,12 +970,6 @@ float AbstractCircuitLoader::_importMorphologies(
         uris = circuit.getMorphologyURIs(gids);
     }
 
-    PropertyMap morphologyProps(properties);
-
-    std::vector<Gid> localGids;
-    for (const auto gid : gids)
-        localGids.push_back(gid);
-
     std::vector<ParallelModelContainer> containers;
     uint64_t morphologyId;
 #pragma omp parallel for private(morphologyId)
@@ -932,8 +1009,10 @@ float AbstractCircuitLoader::_importMorphologies(
                 (layerId < MITOCHONDRIA_DENSITY.size()
                      ? MITOCHONDRIA_DENSITY[layerId]
                      : 0.f);
+            const auto index = somaOffsets.empty() ? morphologyId
+                                                   : somaOffsets[morphologyId];
             ParallelModelContainer modelContainer =
-                loader.importMorphology(gid, morphologyProps, uri, morphologyId,
+                loader.importMorphology(gid, morphologyProps, uri, index,
                                         synapsesInfo,
                                         transformations[morphologyId],
                                         compartmentReport, mitochondriaDensity);
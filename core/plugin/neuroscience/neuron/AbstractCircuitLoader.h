@@ -109,7 +109,7 @@ private:
         const GIDOffsets &targetGIDOffsets,
         CompartmentReportPtr compartmentReport, const size_ts &layerIds,
         const size_ts &morphologyTypes, const size_ts &electrophysiologyTypes,
-        const LoaderProgress &callback,
+        const bool somasOnly, const LoaderProgress &callback,
         const size_t materialId = NO_MATERIAL) const;
 
     /**
@@ -139,7 +139,8 @@ private:
     CompartmentReportPtr _attachSimulationHandler(
         const PropertyMap &properties,
         const brion::BlueConfig &blueConfiguration, Model &model,
-        const ReportType &reportType, brain::GIDSet &gids) const;
+        const ReportType &reportType, brain::GIDSet &gids,
+        const bool somasOnly) const;
 
     void _filterGIDsWithClippingPlanes(brain::GIDSet &gids,
                                        Matrix4fs &transformations) const;
@@ -66,6 +66,9 @@ PropertyMap AdvancedCircuitLoader::getCLIProperties()
     pm.setProperty(PROP_REPORT);
     pm.setProperty(PROP_REPORT_TYPE);
     pm.setProperty(PROP_SYNCHRONOUS_MODE);
+    pm.setProperty(PROP_PREFETCH_DEPTH);
+    pm.setProperty(PROP_FRAME_CACHE_SIZE);
+    pm.setProperty(PROP_REPLAY_FILE);
     pm.setProperty(PROP_TARGETS);
     pm.setProperty(PROP_GIDS);
     pm.setProperty(PROP_CIRCUIT_COLOR_SCHEME);
@@ -73,6 +76,7 @@ PropertyMap AdvancedCircuitLoader::getCLIProperties()
     pm.setProperty(PROP_MESH_FOLDER);
     pm.setProperty(PROP_MESH_FILENAME_PATTERN);
     pm.setProperty(PROP_MESH_TRANSFORMATION);
+    pm.setProperty(PROP_MAX_DISTANCE_TO_SIMULATION_MODEL);
     pm.setProperty(PROP_RADIUS_MULTIPLIER);
     pm.setProperty(PROP_RADIUS_CORRECTION);
     pm.setProperty(PROP_SECTION_TYPE_SOMA);
@@ -41,15 +41,21 @@ CellGrowthHandler::CellGrowthHandler(const CellGrowthHandler& rhs)
 
 CellGrowthHandler::~CellGrowthHandler() {}
 
-void* CellGrowthHandler::getFrameData(const uint32_t frame)
+void* CellGrowthHandler::getFrameData(const uint32_t /*frame*/)
 {
-    if (_currentFrame != frame)
+    // The growth itself is performed by the cell growth renderer, from the
+    // simulation offsets of the primitives and the growth distance. The frame
+    // only maps distances to the soma to themselves, and is therefore
+    // independent from the animation: the handler always reports the same
+    // frame so that the buffer is uploaded once. It is only rebuilt when the
+    // maximum distance to the soma changes.
+    if (_frameData.size() != _frameSize)
     {
         _frameData.resize(_frameSize);
         for (uint64_t i = 0; i < _frameSize; ++i)
-            _frameData[i] = (i < frame ? i : _frameSize);
-        _currentFrame = frame;
+            _frameData[i] = i;
     }
+    _currentFrame = 0;
     return _frameData.data();
 }
 
@@ -30,7 +30,9 @@ namespace neuroscience
 namespace neuron
 {
 /**
- * @brief The CellGrowthHandler class handles distance to the soma
+ * @brief The CellGrowthHandler class handles distance to the soma. Frames
+ * are static, the growth distance being a parameter of the cell growth
+ * renderer that follows the animation.
  */
 class CellGrowthHandler : public brayns::AbstractSimulationHandler
 {
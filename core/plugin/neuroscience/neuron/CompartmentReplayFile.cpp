@@ -0,0 +1,279 @@
+/* Copyright (c) 2018-2022, EPFL/Blue Brain Project
+ * All rights reserved. Do not distribute without permission.
+ * Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "CompartmentReplayFile.h"
+
+#include <common/Logs.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace circuitexplorer
+{
+namespace neuroscience
+{
+namespace neuron
+{
+const char REPLAY_FILE_MAGIC[4] = {'C', 'E', 'Q', 'R'};
+const uint32_t REPLAY_FILE_VERSION = 2;
+
+namespace
+{
+template <typename T>
+void writeValue(std::ostream& stream, const T& value)
+{
+    stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+void readValue(std::istream& stream, T& value)
+{
+    stream.read(reinterpret_cast<char*>(&value), sizeof(T));
+}
+
+template <typename T>
+void quantize(const floats& values, const float minValue, const float maxValue,
+              uint8_t* output, double& maxError, double& sumSquaredErrors)
+{
+    const float maxQuantizedValue = std::numeric_limits<T>::max();
+    const float range = maxValue - minValue;
+    const float scale = (range > 0.f ? maxQuantizedValue / range : 0.f);
+    const float invScale = (range > 0.f ? range / maxQuantizedValue : 0.f);
+    T* quantizedValues = reinterpret_cast<T*>(output);
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        // Missing values cannot be stored and are left to the caller
+        if (std::isnan(values[i]))
+        {
+            quantizedValues[i] = 0;
+            continue;
+        }
+        const float value = std::min(maxValue, std::max(minValue, values[i]));
+        const T quantizedValue =
+            static_cast<T>(std::round((value - minValue) * scale));
+        quantizedValues[i] = quantizedValue;
+
+        const double error =
+            std::abs(minValue + quantizedValue * invScale - values[i]);
+        maxError = std::max(maxError, error);
+        sumSquaredErrors += error * error;
+    }
+}
+
+template <typename T>
+void dequantize(const uint8_t* input, const float minValue,
+                const float maxValue, floats& values)
+{
+    const float maxQuantizedValue = std::numeric_limits<T>::max();
+    const float invScale = (maxValue - minValue) / maxQuantizedValue;
+    const T* quantizedValues = reinterpret_cast<const T*>(input);
+    for (size_t i = 0; i < values.size(); ++i)
+        values[i] = minValue + quantizedValues[i] * invScale;
+}
+} // namespace
+
+CompartmentReplayFile::CompartmentReplayFile(const std::string& path)
+    : _path(path)
+    , _file(path, std::ios::in | std::ios::binary)
+{
+    if (!_file.good())
+        PLUGIN_THROW("Could not open replay file " + path);
+
+    _readHeader(_file, _header);
+    if (!_file.good() ||
+        memcmp(_header.magic, REPLAY_FILE_MAGIC, sizeof(REPLAY_FILE_MAGIC)) !=
+            0)
+        PLUGIN_THROW(path + " is not a valid replay file");
+    if (_header.version != REPLAY_FILE_VERSION)
+        PLUGIN_THROW("Unsupported replay file version: " +
+                     std::to_string(_header.version));
+    if (_header.bitsPerValue != 8 && _header.bitsPerValue != 16)
+        PLUGIN_THROW("Unsupported number of bits per value: " +
+                     std::to_string(_header.bitsPerValue));
+
+    _frameBytes = _getFrameBytes(_header);
+
+    PLUGIN_INFO("Replay file " << path << ": " << _header.nbFrames
+                               << " frames of " << _header.frameSize
+                               << " values quantized to "
+                               << int(_header.bitsPerValue) << " bits ("
+                               << (_header.perFrameScaling ? "per-frame"
+                                                           : "fixed range")
+                               << " scaling)");
+}
+
+void CompartmentReplayFile::_writeHeader(std::ostream& stream,
+                                         const Header& header)
+{
+    // Fields are serialized one by one so that the file does not depend on
+    // the padding of the Header structure
+    stream.write(header.magic, sizeof(header.magic));
+    writeValue(stream, header.version);
+    writeValue(stream, header.frameSize);
+    writeValue(stream, header.nbFrames);
+    writeValue(stream, header.bitsPerValue);
+    writeValue(stream, header.perFrameScaling);
+    writeValue(stream, header.range[0]);
+    writeValue(stream, header.range[1]);
+}
+
+void CompartmentReplayFile::_readHeader(std::istream& stream, Header& header)
+{
+    stream.read(header.magic, sizeof(header.magic));
+    readValue(stream, header.version);
+    readValue(stream, header.frameSize);
+    readValue(stream, header.nbFrames);
+    readValue(stream, header.bitsPerValue);
+    readValue(stream, header.perFrameScaling);
+    readValue(stream, header.range[0]);
+    readValue(stream, header.range[1]);
+}
+
+uint64_t CompartmentReplayFile::_getFrameBytes(const Header& header)
+{
+    const uint64_t rangeBytes = header.perFrameScaling ? 2 * sizeof(float) : 0;
+    return rangeBytes + header.frameSize * header.bitsPerValue / 8;
+}
+
+ReplayQuantizationError CompartmentReplayFile::create(
+    const std::string& path, const uint64_t frameSize, const uint64_t nbFrames,
+    const FrameLoader& loadFrame, const uint8_t bitsPerValue,
+    const bool perFrameScaling, const Vector2f& range,
+    const ProgressCallback& progress)
+{
+    if (bitsPerValue != 8 && bitsPerValue != 16)
+        PLUGIN_THROW("Unsupported number of bits per value: " +
+                     std::to_string(bitsPerValue) + ". Must be 8 or 16");
+    if (frameSize == 0)
+        PLUGIN_THROW("Cannot create a replay file from empty frames");
+
+    std::ofstream file(path, std::ios::out | std::ios::binary);
+    if (!file.good())
+        PLUGIN_THROW("Could not create replay file " + path);
+
+    Header header{};
+    memcpy(header.magic, REPLAY_FILE_MAGIC, sizeof(REPLAY_FILE_MAGIC));
+    header.version = REPLAY_FILE_VERSION;
+    header.frameSize = frameSize;
+    header.nbFrames = nbFrames;
+    header.bitsPerValue = bitsPerValue;
+    header.perFrameScaling = perFrameScaling;
+    header.range[0] = range.x;
+    header.range[1] = range.y;
+    _writeHeader(file, header);
+
+    std::vector<uint8_t> buffer(_getFrameBytes(header));
+    double maxError = 0.0;
+    double sumSquaredErrors = 0.0;
+    for (uint64_t frame = 0; frame < nbFrames; ++frame)
+    {
+        PLUGIN_PROGRESS("- Quantizing simulation frames", frame, nbFrames);
+        if (progress)
+            progress(float(frame) / float(nbFrames));
+        const auto values = loadFrame(frame);
+        if (values.size() != frameSize)
+            PLUGIN_THROW("Invalid size for frame " + std::to_string(frame));
+
+        float minValue = range.x;
+        float maxValue = range.y;
+        uint8_t* output = buffer.data();
+        if (perFrameScaling)
+        {
+            // Missing values (NaN) do not contribute to the range
+            minValue = std::numeric_limits<float>::max();
+            maxValue = -std::numeric_limits<float>::max();
+            for (const auto value : values)
+            {
+                if (std::isnan(value))
+                    continue;
+                minValue = std::min(minValue, value);
+                maxValue = std::max(maxValue, value);
+            }
+            if (minValue > maxValue)
+                minValue = maxValue = 0.f;
+            memcpy(output, &minValue, sizeof(float));
+            memcpy(output + sizeof(float), &maxValue, sizeof(float));
+            output += 2 * sizeof(float);
+        }
+
+        if (bitsPerValue == 8)
+            quantize<uint8_t>(values, minValue, maxValue, output, maxError,
+                              sumSquaredErrors);
+        else
+            quantize<uint16_t>(values, minValue, maxValue, output, maxError,
+                               sumSquaredErrors);
+
+        file.write((char*)buffer.data(), buffer.size());
+        if (!file.good())
+            PLUGIN_THROW("Failed to write frame " + std::to_string(frame) +
+                         " to replay file " + path);
+    }
+
+    if (progress)
+        progress(1.f);
+
+    ReplayQuantizationError error;
+    error.maxError = maxError;
+    const uint64_t nbValues = frameSize * nbFrames;
+    if (nbValues > 0)
+        error.rmsError = std::sqrt(sumSquaredErrors / nbValues);
+
+    PLUGIN_INFO("Replay file "
+                << path << " created (" << int(bitsPerValue) << " bits, "
+                << (perFrameScaling ? "per-frame" : "fixed range")
+                << " scaling). Quantization error: max=" << error.maxError
+                << ", rms=" << error.rmsError);
+    return error;
+}
+
+void CompartmentReplayFile::readFrame(const uint64_t frame, floats& data)
+{
+    if (frame >= _header.nbFrames)
+        PLUGIN_THROW("Invalid replay frame " + std::to_string(frame));
+
+    std::vector<uint8_t> buffer(_frameBytes);
+    {
+        std::lock_guard<std::mutex> lock(_fileMutex);
+        _file.seekg(HEADER_SIZE + frame * _frameBytes, std::ios::beg);
+        _file.read((char*)buffer.data(), buffer.size());
+        if (!_file.good())
+            PLUGIN_THROW("Failed to read frame " + std::to_string(frame) +
+                         " from replay file " + _path);
+    }
+
+    float minValue = _header.range[0];
+    float maxValue = _header.range[1];
+    const uint8_t* input = buffer.data();
+    if (_header.perFrameScaling)
+    {
+        memcpy(&minValue, input, sizeof(float));
+        memcpy(&maxValue, input + sizeof(float), sizeof(float));
+        input += 2 * sizeof(float);
+    }
+
+    data.resize(_header.frameSize);
+    if (_header.bitsPerValue == 8)
+        dequantize<uint8_t>(input, minValue, maxValue, data);
+    else
+        dequantize<uint16_t>(input, minValue, maxValue, data);
+}
+} // namespace neuron
+} // namespace neuroscience
+} // namespace circuitexplorer
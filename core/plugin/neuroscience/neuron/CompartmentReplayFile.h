@@ -0,0 +1,123 @@
+/* Copyright (c) 2018-2022, EPFL/Blue Brain Project
+ * All rights reserved. Do not distribute without permission.
+ * Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#pragma once
+
+#include <brayns/common/types.h>
+
+#include <fstream>
+#include <functional>
+#include <mutex>
+
+namespace circuitexplorer
+{
+namespace neuroscience
+{
+namespace neuron
+{
+using namespace brayns;
+
+/**
+ * @brief Error introduced by the quantization of a compartment report, in the
+ * unit of the report (typically mV)
+ */
+struct ReplayQuantizationError
+{
+    double maxError{0.0};
+    double rmsError{0.0};
+};
+
+/**
+ * @brief The CompartmentReplayFile class handles a local copy of a compartment
+ * report where values are quantized to 8 or 16 bits. Values are either
+ * quantized within a fixed range, or within the range of values of each frame
+ * (per-frame scaling). Replay files are meant to be stored on a local drive to
+ * reduce the I/O required by the playback of large circuits.
+ */
+class CompartmentReplayFile
+{
+public:
+    using FrameLoader = std::function<floats(const uint64_t)>;
+    using ProgressCallback = std::function<void(const float)>;
+
+    /**
+     * @brief Opens an existing replay file
+     * @param path Path to the replay file
+     */
+    CompartmentReplayFile(const std::string& path);
+
+    /**
+     * @brief Creates a replay file from a compartment report
+     * @param path Path to the replay file
+     * @param frameSize Number of values per frame, must not be 0
+     * @param nbFrames Number of frames
+     * @param loadFrame Function returning the values of a given frame
+     * @param bitsPerValue Number of bits per quantized value (8 or 16)
+     * @param perFrameScaling Quantize values within the range of each frame
+     * @param range Range of values used when perFrameScaling is false. Values
+     * outside of the range are clamped
+     * @param progress Optional function receiving the progress of the
+     * creation, from 0 to 1
+     * @return The error introduced by the quantization
+     */
+    static ReplayQuantizationError create(
+        const std::string& path, const uint64_t frameSize,
+        const uint64_t nbFrames, const FrameLoader& loadFrame,
+        const uint8_t bitsPerValue, const bool perFrameScaling,
+        const Vector2f& range, const ProgressCallback& progress = {});
+
+    /**
+     * @brief Reads and decodes a frame. This function is thread safe
+     * @param frame Index of the frame, from 0 to the number of frames
+     * @param data Decoded values
+     */
+    void readFrame(const uint64_t frame, floats& data);
+
+    const std::string& getPath() const { return _path; }
+    uint64_t getFrameSize() const { return _header.frameSize; }
+    uint64_t getNbFrames() const { return _header.nbFrames; }
+
+private:
+    struct Header
+    {
+        char magic[4];
+        uint32_t version;
+        uint64_t frameSize;
+        uint64_t nbFrames;
+        uint8_t bitsPerValue;
+        uint8_t perFrameScaling;
+        float range[2];
+    };
+
+    /** Size of the serialized header, without padding */
+    static const uint64_t HEADER_SIZE = 4 + 4 + 8 + 8 + 1 + 1 + 2 * 4;
+
+    static void _writeHeader(std::ostream& stream, const Header& header);
+    static void _readHeader(std::istream& stream, Header& header);
+    static uint64_t _getFrameBytes(const Header& header);
+
+    std::string _path;
+    std::ifstream _file;
+    std::mutex _fileMutex;
+    Header _header;
+    uint64_t _frameBytes{0};
+};
+using CompartmentReplayFilePtr = std::shared_ptr<CompartmentReplayFile>;
+} // namespace neuron
+} // namespace neuroscience
+} // namespace circuitexplorer
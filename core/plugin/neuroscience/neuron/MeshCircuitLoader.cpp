@@ -96,12 +96,16 @@ PropertyMap MeshCircuitLoader::getCLIProperties()
     pm.setProperty(PROP_DENSITY);
     pm.setProperty(PROP_REPORT);
     pm.setProperty(PROP_SYNCHRONOUS_MODE);
+    pm.setProperty(PROP_PREFETCH_DEPTH);
+    pm.setProperty(PROP_FRAME_CACHE_SIZE);
+    pm.setProperty(PROP_REPLAY_FILE);
     pm.setProperty(PROP_TARGETS);
     pm.setProperty(PROP_GIDS);
     pm.setProperty(PROP_RANDOM_SEED);
     pm.setProperty(PROP_MESH_FOLDER);
     pm.setProperty(PROP_MESH_FILENAME_PATTERN);
     pm.setProperty(PROP_MESH_TRANSFORMATION);
+    pm.setProperty(PROP_MAX_DISTANCE_TO_SIMULATION_MODEL);
     pm.setProperty(PROP_SECTION_TYPE_SOMA);
     pm.setProperty(PROP_SECTION_TYPE_AXON);
     pm.setProperty(PROP_SECTION_TYPE_DENDRITE);
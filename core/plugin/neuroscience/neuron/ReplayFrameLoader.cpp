@@ -0,0 +1,101 @@
+/* Copyright (c) 2018-2022, EPFL/Blue Brain Project
+ * All rights reserved. Do not distribute without permission.
+ * Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "ReplayFrameLoader.h"
+
+#include <algorithm>
+
+namespace circuitexplorer
+{
+namespace neuroscience
+{
+namespace neuron
+{
+ReplayFrameLoader::ReplayFrameLoader(const CompartmentReplayFilePtr& replayFile)
+    : _replayFile(replayFile)
+    , _thread(&ReplayFrameLoader::_run, this)
+{
+}
+
+ReplayFrameLoader::~ReplayFrameLoader()
+{
+    {
+        // Queued frames are dropped, only the frame being read is waited for
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+        _queue.clear();
+    }
+    _condition.notify_one();
+    _thread.join();
+}
+
+std::future<brion::Frame> ReplayFrameLoader::load(const uint64_t frame,
+                                                  const float timestamp)
+{
+    Request request;
+    request.frame = frame;
+    request.timestamp = timestamp;
+    auto future = request.promise.get_future();
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _queue.push_back(std::move(request));
+    }
+    _condition.notify_one();
+    return future;
+}
+
+void ReplayFrameLoader::cancel(const uint64_t frame)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _queue.erase(std::remove_if(_queue.begin(), _queue.end(),
+                                [frame](const Request& request)
+                                { return request.frame == frame; }),
+                 _queue.end());
+}
+
+void ReplayFrameLoader::_run()
+{
+    while (true)
+    {
+        Request request;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _condition.wait(lock, [this] { return _stop || !_queue.empty(); });
+            if (_stop)
+                return;
+            request = std::move(_queue.front());
+            _queue.pop_front();
+        }
+
+        try
+        {
+            brion::Frame replayFrame;
+            replayFrame.timestamp = request.timestamp;
+            replayFrame.data = std::make_shared<floats>();
+            _replayFile->readFrame(request.frame, *replayFrame.data);
+            request.promise.set_value(replayFrame);
+        }
+        catch (...)
+        {
+            request.promise.set_exception(std::current_exception());
+        }
+    }
+}
+} // namespace neuron
+} // namespace neuroscience
+} // namespace circuitexplorer
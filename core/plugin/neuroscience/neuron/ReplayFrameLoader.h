@@ -0,0 +1,83 @@
+/* Copyright (c) 2018-2022, EPFL/Blue Brain Project
+ * All rights reserved. Do not distribute without permission.
+ * Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#pragma once
+
+#include "CompartmentReplayFile.h"
+
+#include <plugin/neuroscience/common/Types.h>
+
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
+
+namespace circuitexplorer
+{
+namespace neuroscience
+{
+namespace neuron
+{
+/**
+ * @brief The ReplayFrameLoader class reads the frames of a replay file in a
+ * persistent background thread. Frames are delivered through promises, so that
+ * discarding their futures never waits for the read to complete. Queued frames
+ * can be cancelled before they are read.
+ */
+class ReplayFrameLoader
+{
+public:
+    ReplayFrameLoader(const CompartmentReplayFilePtr& replayFile);
+    ~ReplayFrameLoader();
+
+    /**
+     * @brief Queues the loading of a frame
+     * @param frame Index of the frame in the replay file
+     * @param timestamp Timestamp of the frame in the compartment report
+     * @return Future holding the frame once it is read
+     */
+    std::future<brion::Frame> load(const uint64_t frame,
+                                   const float timestamp);
+
+    /**
+     * @brief Removes a frame from the queue if it is not being read yet
+     */
+    void cancel(const uint64_t frame);
+
+private:
+    struct Request
+    {
+        uint64_t frame;
+        float timestamp;
+        std::promise<brion::Frame> promise;
+    };
+
+    void _run();
+
+    CompartmentReplayFilePtr _replayFile;
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    std::deque<Request> _queue;
+    bool _stop{false};
+    std::thread _thread;
+};
+using ReplayFrameLoaderPtr = std::shared_ptr<ReplayFrameLoader>;
+} // namespace neuron
+} // namespace neuroscience
+} // namespace circuitexplorer
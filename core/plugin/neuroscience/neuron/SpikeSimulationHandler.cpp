@@ -19,8 +19,13 @@
 #include <common/Logs.h>
 
 #include "SpikeSimulationHandler.h"
+#include <brayns/common/Timer.h>
 #include <brayns/parameters/AnimationParameters.h>
 
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
 namespace circuitexplorer
 {
 namespace neuroscience
@@ -38,19 +43,21 @@ SpikeSimulationHandler::SpikeSimulationHandler(const std::string& reportPath,
     , _reportPath(reportPath)
     , _gids(gids)
     , _spikeReport(new brain::SpikeReportReader(brain::URI(reportPath), gids))
+    , _cacheSourceId(SimulationFrameCache::getInstance().createSourceId())
+    , _statisticsCollector(std::make_shared<SimulationStatisticsCollector>())
 {
-    uint64_t c{0};
-    for (const auto gid : _gids)
-    {
-        _gidMap[gid] = c;
-        ++c;
-    }
+    _loadSpikes();
 
     // Load simulation information from compartment reports
     _nbFrames = _spikeReport->getEndTime() / DEFAULT_TIME_INTERVAL;
     _dt = DEFAULT_TIME_INTERVAL;
     _frameSize = _gids.size();
-    _frameData.resize(_frameSize, DEFAULT_REST_VALUE);
+    _frameBuffer = std::make_shared<floats>(_frameSize, DEFAULT_REST_VALUE);
+    _lastSpikeTimes.resize(_frameSize);
+
+    // Time needed for a spiking cell to get back to its resting value
+    _decayWindow = _dt * (DEFAULT_SPIKING_VALUE - DEFAULT_REST_VALUE) /
+                   DEFAULT_DECAY_SPEED;
 
     PLUGIN_INFO("-----------------------------------------------------------");
     PLUGIN_INFO("Spike simulation information");
@@ -58,8 +65,10 @@ SpikeSimulationHandler::SpikeSimulationHandler(const std::string& reportPath,
     PLUGIN_INFO("Report path           : " << _reportPath);
     PLUGIN_INFO("Frame size (# of GIDs): " << _frameSize);
     PLUGIN_INFO("End time              : " << _spikeReport->getEndTime());
+    PLUGIN_INFO("Number of spikes      : " << _spikes->times.size());
     PLUGIN_INFO("Time interval         : " << DEFAULT_TIME_INTERVAL);
     PLUGIN_INFO("Decay speed           : " << DEFAULT_DECAY_SPEED);
+    PLUGIN_INFO("Decay window          : " << _decayWindow);
     PLUGIN_INFO("Number of frames      : " << _nbFrames);
     PLUGIN_INFO("-----------------------------------------------------------");
 }
@@ -70,7 +79,12 @@ SpikeSimulationHandler::SpikeSimulationHandler(
     , _reportPath(rhs._reportPath)
     , _gids(rhs._gids)
     , _spikeReport(rhs._spikeReport)
-    , _gidMap(rhs._gidMap)
+    , _cacheSourceId(rhs._cacheSourceId)
+    , _spikes(rhs._spikes)
+    , _frameBuffer(rhs._frameBuffer)
+    , _statisticsCollector(rhs._statisticsCollector)
+    , _lastSpikeTimes(rhs._lastSpikeTimes)
+    , _decayWindow(rhs._decayWindow)
 {
 }
 
@@ -79,27 +93,114 @@ void* SpikeSimulationHandler::getFrameData(const uint32_t frame)
     const auto boundedFrame = _getBoundedFrame(frame);
     if (_currentFrame != boundedFrame)
     {
-        for (size_t i = 0; i < _frameSize; ++i)
+        auto& cache = SimulationFrameCache::getInstance();
+        _frameBuffer = cache.get(_cacheSourceId, boundedFrame);
+        if (!_frameBuffer)
         {
-            if (_frameData[i] > DEFAULT_REST_VALUE)
-                _frameData[i] -= DEFAULT_DECAY_SPEED;
-            else
-                _frameData[i] = DEFAULT_REST_VALUE;
+            // Buffers are shared with the cache and the renderer, a new one is
+            // needed for every frame
+            _frameBuffer = std::make_shared<floats>(_frameSize);
+            _computeFrame(boundedFrame * _dt, *_frameBuffer);
+            cache.put(_cacheSourceId, boundedFrame, _frameBuffer);
         }
+        _statisticsCollector->submit(boundedFrame, _frameBuffer);
+        _currentFrame = boundedFrame;
+    }
 
-        const float ts = boundedFrame * _dt;
-        const float endTime = _spikeReport->getEndTime() - _dt;
-        const auto& spikes =
-            _spikeReport->getSpikes(std::min(ts, endTime),
-                                    std::min(ts + 1.f, endTime));
+    return _frameBuffer->data();
+}
 
-        for (const auto spike : spikes)
-            _frameData[_gidMap[spike.second]] = DEFAULT_SPIKING_VALUE;
+bool SpikeSimulationHandler::getFrameStatistics(
+    const uint32_t frame, SimulationFrameStatistics& statistics) const
+{
+    return _statisticsCollector->getStatistics(_getBoundedFrame(frame),
+                                               statistics);
+}
 
-        _currentFrame = boundedFrame;
+void SpikeSimulationHandler::_loadSpikes()
+{
+    Timer chrono;
+
+    // Dense GID to frame offset table
+    const uint32_t invalidOffset = std::numeric_limits<uint32_t>::max();
+    const uint32_t minGid = _gids.empty() ? 0 : *_gids.begin();
+    const uint32_t maxGid = _gids.empty() ? 0 : *_gids.rbegin();
+    std::vector<uint32_t> gidOffsets(maxGid - minGid + 1, invalidOffset);
+    uint32_t offset = 0;
+    for (const auto gid : _gids)
+        gidOffsets[gid - minGid] = offset++;
+
+    const float endTime = _spikeReport->getEndTime();
+    const auto& spikes = _spikeReport->getSpikes(
+        0.f, std::nextafter(endTime, std::numeric_limits<float>::max()));
+
+    auto index = std::make_shared<SpikeIndex>();
+    index->times.reserve(spikes.size());
+    index->offsets.reserve(spikes.size());
+    for (const auto& spike : spikes)
+    {
+        if (spike.second < minGid || spike.second > maxGid)
+            continue;
+        const auto spikeOffset = gidOffsets[spike.second - minGid];
+        if (spikeOffset == invalidOffset)
+            continue;
+        index->times.push_back(spike.first);
+        index->offsets.push_back(spikeOffset);
+    }
+
+    // Binary search requires spikes to be sorted by time
+    if (!std::is_sorted(index->times.begin(), index->times.end()))
+    {
+        std::vector<size_t> order(index->times.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(),
+                         [&index](const size_t a, const size_t b)
+                         { return index->times[a] < index->times[b]; });
+        floats times(order.size());
+        std::vector<uint32_t> offsets(order.size());
+        for (size_t i = 0; i < order.size(); ++i)
+        {
+            times[i] = index->times[order[i]];
+            offsets[i] = index->offsets[order[i]];
+        }
+        index->times = std::move(times);
+        index->offsets = std::move(offsets);
     }
+    _spikes = index;
+    PLUGIN_TIMER(chrono.elapsed(),
+                 "- " << _spikes->times.size() << " spikes indexed");
+}
+
+void SpikeSimulationHandler::_computeFrame(const float timestamp,
+                                           floats& frame)
+{
+    // Only spikes that occurred within the decay window have an influence on
+    // the current frame. For every cell, the value only depends on the time
+    // elapsed since its last spike, which makes any frame reproducible
+    // regardless of the frames that were previously visited.
+    const float endTime = _spikeReport->getEndTime();
+    const float ts = std::min(timestamp, endTime);
+    const auto& times = _spikes->times;
+    const auto& offsets = _spikes->offsets;
+    const auto begin =
+        std::lower_bound(times.begin(), times.end(), ts - _decayWindow);
+    const auto end = std::upper_bound(begin, times.end(), ts);
 
-    return _frameData.data();
+    // Spikes are sorted by time, the last one of each cell is kept
+    std::fill(_lastSpikeTimes.begin(), _lastSpikeTimes.end(),
+              -std::numeric_limits<float>::max());
+    for (auto it = begin; it != end; ++it)
+        _lastSpikeTimes[offsets[it - times.begin()]] = *it;
+
+    const float decayPerTimeUnit = DEFAULT_DECAY_SPEED / _dt;
+#pragma omp parallel for
+    for (size_t i = 0; i < _frameSize; ++i)
+    {
+        const float elapsedTime = ts - _lastSpikeTimes[i];
+        frame[i] =
+            std::max(DEFAULT_REST_VALUE,
+                     DEFAULT_SPIKING_VALUE - elapsedTime * decayPerTimeUnit);
+    }
 }
 
 AbstractSimulationHandlerPtr SpikeSimulationHandler::clone() const
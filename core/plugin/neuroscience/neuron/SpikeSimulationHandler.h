@@ -18,6 +18,9 @@
 
 #pragma once
 
+#include <plugin/neuroscience/common/SimulationFrameCache.h>
+#include <plugin/neuroscience/common/SimulationStatisticsCollector.h>
+
 #include <brain/brain.h>
 #include <brayns/api.h>
 #include <brayns/common/simulation/AbstractSimulationHandler.h>
@@ -31,9 +34,21 @@ namespace neuroscience
 namespace neuron
 {
 using namespace brayns;
+using namespace common;
 
 typedef std::shared_ptr<brain::SpikeReportReader> SpikeReportReaderPtr;
 
+/**
+ * @brief The SpikeSimulationHandler class turns spikes into simulation frames.
+ * The value of a cell decays linearly from the spiking value to the resting
+ * value, according to the time elapsed since its last spike. Frames are
+ * computed independently from each other and can therefore be accessed in any
+ * order.
+ *
+ * The spike report is loaded once into time-sorted columnar arrays (spike
+ * times and offsets of the spiking cells in the frame), shared by all clones of
+ * the handler. Spikes within a time window are then found by binary search.
+ */
 class SpikeSimulationHandler : public AbstractSimulationHandler
 {
 public:
@@ -46,14 +61,37 @@ public:
     const std::string& getReportPath() const { return _reportPath; }
     SpikeReportReaderPtr getReport() const { return _spikeReport; }
     const brain::GIDSet& getGIDs() const { return _gids; }
+
+    /**
+     * @brief Returns the statistics of a frame, computed in the background
+     * once the frame has been produced
+     * @return True if the statistics of the frame are available
+     */
+    bool getFrameStatistics(const uint32_t frame,
+                            SimulationFrameStatistics& statistics) const;
     AbstractSimulationHandlerPtr clone() const final;
 
 private:
+    struct SpikeIndex
+    {
+        floats times;
+        std::vector<uint32_t> offsets;
+    };
+    using SpikeIndexPtr = std::shared_ptr<const SpikeIndex>;
+
+    void _loadSpikes();
+    void _computeFrame(const float timestamp, floats& frame);
+
     std::string _reportPath;
     brain::GIDSet _gids;
     SpikeReportReaderPtr _spikeReport;
+    uint64_t _cacheSourceId{0};
 
-    std::map<uint64_t, uint64_t> _gidMap;
+    SpikeIndexPtr _spikes;
+    FrameBufferPtr _frameBuffer;
+    SimulationStatisticsCollectorPtr _statisticsCollector;
+    floats _lastSpikeTimes;
+    float _decayWindow{0.f};
 };
 using SpikeSimulationHandlerPtr = std::shared_ptr<SpikeSimulationHandler>;
 } // namespace neuron
@@ -22,20 +22,31 @@
 
 #include <brayns/parameters/AnimationParameters.h>
 
+#include <limits>
+#include <set>
+
 namespace circuitexplorer
 {
 namespace neuroscience
 {
 namespace neuron
 {
+// Offset of the soma of cells that have no valid compartment in the report
+const uint64_t NO_SOMA_OFFSET = std::numeric_limits<uint64_t>::max();
+
 VoltageSimulationHandler::VoltageSimulationHandler(
     const std::string& reportPath, const brion::GIDSet& gids,
-    const bool synchronousMode)
+    const bool synchronousMode, const uint32_t prefetchDepth,
+    const bool somasOnly)
     : AbstractSimulationHandler()
     , _synchronousMode(synchronousMode)
     , _reportPath(reportPath)
     , _compartmentReport(new brion::CompartmentReport(brion::URI(reportPath),
                                                       brion::MODE_READ, gids))
+    , _somasOnly(somasOnly)
+    , _cacheSourceId(SimulationFrameCache::getInstance().createSourceId())
+    , _statisticsCollector(std::make_shared<SimulationStatisticsCollector>())
+    , _prefetchDepth(prefetchDepth)
 {
     // Load simulation information from compartment reports
     _dt = _compartmentReport->getTimestep();
@@ -45,6 +56,32 @@ VoltageSimulationHandler::VoltageSimulationHandler(
     _nbFrames = (endTime - startTime) / _dt;
     _unit = _compartmentReport->getTimeUnit();
     _frameSize = _compartmentReport->getFrameSize();
+    const auto reportFrameSize = _frameSize;
+
+    if (_somasOnly)
+    {
+        // The soma is the first section of each cell. Cells without valid
+        // compartments keep their index, so that the mapping of the geometry
+        // is preserved, but carry no simulation data
+        const auto& offsets = _compartmentReport->getOffsets();
+        _somaOffsets.reserve(offsets.size());
+        size_t nbCellsWithoutData = 0;
+        for (const auto& cellOffsets : offsets)
+        {
+            if (cellOffsets.empty() || cellOffsets[0] >= reportFrameSize)
+            {
+                _somaOffsets.push_back(NO_SOMA_OFFSET);
+                ++nbCellsWithoutData;
+            }
+            else
+                _somaOffsets.push_back(cellOffsets[0]);
+        }
+        _frameSize = _somaOffsets.size();
+        if (nbCellsWithoutData > 0)
+            PLUGIN_WARN(nbCellsWithoutData
+                        << " cells have no soma compartment in report "
+                        << reportPath << " and carry no simulation data");
+    }
 
     PLUGIN_INFO("-----------------------------------------------------------");
     PLUGIN_INFO("Voltage simulation information");
@@ -54,6 +91,9 @@ VoltageSimulationHandler::VoltageSimulationHandler(
     PLUGIN_INFO("Steps between frames : " << _dt);
     PLUGIN_INFO("Number of frames     : " << _nbFrames);
     PLUGIN_INFO("Frame size           : " << _frameSize);
+    if (_somasOnly)
+        PLUGIN_INFO("Report frame size    : " << reportFrameSize);
+    PLUGIN_INFO("Prefetch depth       : " << _prefetchDepth);
     PLUGIN_INFO("-----------------------------------------------------------");
 }
 
@@ -61,8 +101,21 @@ VoltageSimulationHandler::VoltageSimulationHandler(
     const VoltageSimulationHandler& rhs)
     : AbstractSimulationHandler(rhs)
     , _synchronousMode(rhs._synchronousMode)
+    , _reportPath(rhs._reportPath)
     , _compartmentReport(rhs._compartmentReport)
+    , _replayFile(rhs._replayFile)
+    , _replayLoader(rhs._replayFile
+                        ? std::make_shared<ReplayFrameLoader>(rhs._replayFile)
+                        : nullptr)
+    , _somasOnly(rhs._somasOnly)
+    , _somaOffsets(rhs._somaOffsets)
+    , _cacheSourceId(rhs._cacheSourceId)
+    , _startFrame(rhs._startFrame)
     , _ready(false)
+    , _frameBuffer(rhs._frameBuffer)
+    , _statisticsCollector(rhs._statisticsCollector)
+    , _simulationMappings(rhs._simulationMappings)
+    , _prefetchDepth(rhs._prefetchDepth)
 {
 }
 
@@ -78,53 +131,217 @@ bool VoltageSimulationHandler::isReady() const
     return _ready;
 }
 
+bool VoltageSimulationHandler::getFrameStatistics(
+    const uint32_t frame, SimulationFrameStatistics& statistics) const
+{
+    return _statisticsCollector->getStatistics(_startFrame +
+                                                   _getBoundedFrame(frame),
+                                               statistics);
+}
+
+double VoltageSimulationHandler::getAverageFrameWaitTime() const
+{
+    if (_nbLoadedFrames == 0)
+        return 0.0;
+    return _totalFrameWaitTime / _nbLoadedFrames;
+}
+
 void* VoltageSimulationHandler::getFrameData(const uint32_t frame)
 {
     const auto boundedFrame = _startFrame + _getBoundedFrame(frame);
 
-    if (!_currentFrameFuture.valid() && _currentFrame != boundedFrame)
-        _triggerLoading(boundedFrame);
+    if (boundedFrame != _currentFrame && boundedFrame != _requestedFrame)
+    {
+        // Follow the direction and the step of the playback
+        if (_requestedFrame != std::numeric_limits<uint32_t>::max())
+        {
+            const int64_t step = static_cast<int64_t>(boundedFrame) -
+                                 static_cast<int64_t>(_requestedFrame);
+            if (step != 0)
+                _playbackStep = step;
+        }
+        _requestedFrame = boundedFrame;
+        _requestTime = std::chrono::high_resolution_clock::now();
+        auto cachedFrame =
+            SimulationFrameCache::getInstance().get(_cacheSourceId,
+                                                    boundedFrame);
+        if (cachedFrame)
+        {
+            _frameBuffer = std::move(cachedFrame);
+            _setFrameReady(boundedFrame);
+        }
+        _prefetch(boundedFrame);
+    }
 
     if (!_makeFrameReady(boundedFrame))
         return nullptr;
 
-    return _frameData.data();
+    return _frameBuffer ? _frameBuffer->data() : nullptr;
+}
+
+void VoltageSimulationHandler::_prefetch(const uint32_t frame)
+{
+    // Frames to keep in the queue: the requested one, followed by the next
+    // ones according to the playback. Frame indices wrap around the end of the
+    // report, the same way the animation does.
+    std::set<uint32_t> window{frame};
+    if (_nbFrames > 0)
+    {
+        const int64_t nbFrames = _nbFrames;
+        const int64_t relativeFrame = frame - _startFrame;
+        for (uint32_t i = 1; i <= _prefetchDepth; ++i)
+        {
+            int64_t next = (relativeFrame + i * _playbackStep) % nbFrames;
+            if (next < 0)
+                next += nbFrames;
+            window.insert(_startFrame + next);
+        }
+    }
+
+    // Discard pending loads that are not relevant anymore (e.g. after the user
+    // jumped to another frame or changed the playback direction)
+    for (auto it = _pendingFrames.begin(); it != _pendingFrames.end();)
+    {
+        if (window.find(it->first) == window.end())
+        {
+            if (_replayLoader)
+                _replayLoader->cancel(it->first - _startFrame);
+            it = _pendingFrames.erase(it);
+        }
+        else
+            ++it;
+    }
+
+    // Requested frame first so that it gets the highest priority in the loading
+    // queue of the compartment report
+    _triggerLoading(frame);
+    for (const auto f : window)
+        _triggerLoading(f);
+}
+
+ReplayQuantizationError VoltageSimulationHandler::createReplayFile(
+    const std::string& path, const uint8_t bitsPerValue,
+    const bool perFrameScaling, const Vector2f& range,
+    const CompartmentReplayFile::ProgressCallback& progress) const
+{
+    return CompartmentReplayFile::create(
+        path, _frameSize, _nbFrames,
+        [this](const uint64_t frame)
+        {
+            auto data = _compartmentReport
+                            ->loadFrame(_getTimestamp(_startFrame + frame))
+                            .get()
+                            .data;
+            if (!data)
+                PLUGIN_THROW("Failed to load simulation frame " +
+                             std::to_string(frame));
+            if (!_somasOnly)
+                return *data;
+            floats somas;
+            _extractSomas(*data, somas);
+            return somas;
+        },
+        bitsPerValue, perFrameScaling, range, progress);
+}
+
+void VoltageSimulationHandler::setReplayFile(const std::string& path)
+{
+    CompartmentReplayFilePtr replayFile{nullptr};
+    if (!path.empty())
+    {
+        replayFile = std::make_shared<CompartmentReplayFile>(path);
+        if (replayFile->getFrameSize() != _frameSize ||
+            replayFile->getNbFrames() != _nbFrames)
+            PLUGIN_THROW("Replay file " + path +
+                         " does not match the compartment report");
+    }
+
+    // Frames decoded from the replay file differ from the ones of the report,
+    // they must not share the same cache entries
+    _replayFile = replayFile;
+    _replayLoader =
+        replayFile ? std::make_shared<ReplayFrameLoader>(replayFile) : nullptr;
+    _cacheSourceId = SimulationFrameCache::getInstance().createSourceId();
+    _statisticsCollector = std::make_shared<SimulationStatisticsCollector>();
+    _pendingFrames.clear();
+    _currentFrame = std::numeric_limits<uint32_t>::max();
+    _requestedFrame = std::numeric_limits<uint32_t>::max();
+}
+
+float VoltageSimulationHandler::_getTimestamp(const uint32_t frame) const
+{
+    const float timestamp = frame * _dt;
+    return std::min(static_cast<float>(_nbFrames), timestamp);
 }
 
 void VoltageSimulationHandler::_triggerLoading(const uint32_t frame)
 {
-    float timestamp = frame * _dt;
-    timestamp = std::min(static_cast<float>(_nbFrames), timestamp);
+    if (frame == _currentFrame ||
+        _pendingFrames.find(frame) != _pendingFrames.end() ||
+        SimulationFrameCache::getInstance().contains(_cacheSourceId, frame))
+        return;
 
-    if (_currentFrameFuture.valid())
-        _currentFrameFuture.wait();
+    if (_replayLoader)
+    {
+        _pendingFrames[frame] =
+            _replayLoader->load(frame - _startFrame, _getTimestamp(frame));
+        return;
+    }
 
-    _ready = false;
-    _currentFrameFuture = _compartmentReport->loadFrame(timestamp);
+    _pendingFrames[frame] = _compartmentReport->loadFrame(_getTimestamp(frame));
 }
 
-bool VoltageSimulationHandler::_isFrameLoaded() const
+bool VoltageSimulationHandler::_isFrameLoaded(
+    const std::future<brion::Frame>& future) const
 {
-    if (!_currentFrameFuture.valid())
+    if (!future.valid())
         return false;
 
     if (_synchronousMode)
     {
-        _currentFrameFuture.wait();
+        future.wait();
         return true;
     }
 
-    return _currentFrameFuture.wait_for(std::chrono::milliseconds(0)) ==
+    return future.wait_for(std::chrono::milliseconds(0)) ==
            std::future_status::ready;
 }
 
 bool VoltageSimulationHandler::_makeFrameReady(const uint32_t frame)
 {
-    if (_isFrameLoaded())
+    if (frame == _currentFrame)
+        return true;
+
+    auto it = _pendingFrames.find(frame);
+    if (it == _pendingFrames.end())
+        return true;
+
+    _ready = false;
+    if (_isFrameLoaded(it->second))
     {
+        // The entry is removed exactly once, whatever the outcome of the load
+        auto future = std::move(it->second);
+        _pendingFrames.erase(it);
         try
         {
-            _frameData = std::move(*_currentFrameFuture.get().data);
+            FrameBufferPtr data = future.get().data;
+            if (!data)
+                throw std::runtime_error("Empty frame");
+
+            // The buffer loaded by the report is handed over to the renderer
+            // as is. Frames read from replay files are already reduced to
+            // somas, but cannot store missing values.
+            if (_somasOnly && !_replayFile)
+            {
+                _frameBuffer = std::make_shared<floats>();
+                _extractSomas(*data, *_frameBuffer);
+            }
+            else
+            {
+                _frameBuffer = std::move(data);
+                if (_somasOnly)
+                    _clearMissingSomas(*_frameBuffer);
+            }
         }
         catch (const std::exception& e)
         {
@@ -132,11 +349,47 @@ bool VoltageSimulationHandler::_makeFrameReady(const uint32_t frame)
                                                            << e.what());
             return false;
         }
-        _currentFrame = frame;
-        _ready = true;
+        SimulationFrameCache::getInstance().put(_cacheSourceId, frame,
+                                                _frameBuffer);
+        _setFrameReady(frame);
     }
     return true;
 }
+
+void VoltageSimulationHandler::_extractSomas(const floats& frame,
+                                             floats& somas) const
+{
+    // NaN is the value of simulation data that is not available, and is
+    // rendered transparent by the transfer function
+    somas.resize(_somaOffsets.size());
+    for (size_t i = 0; i < _somaOffsets.size(); ++i)
+        somas[i] = (_somaOffsets[i] == NO_SOMA_OFFSET
+                        ? std::numeric_limits<float>::quiet_NaN()
+                        : frame[_somaOffsets[i]]);
+}
+
+void VoltageSimulationHandler::_clearMissingSomas(floats& somas) const
+{
+    for (size_t i = 0; i < _somaOffsets.size() && i < somas.size(); ++i)
+        if (_somaOffsets[i] == NO_SOMA_OFFSET)
+            somas[i] = std::numeric_limits<float>::quiet_NaN();
+}
+
+void VoltageSimulationHandler::_setFrameReady(const uint32_t frame)
+{
+    _currentFrame = frame;
+    _ready = true;
+    _statisticsCollector->submit(frame, _frameBuffer);
+
+    const auto now = std::chrono::high_resolution_clock::now();
+    _lastFrameWaitTime =
+        std::chrono::duration<double, std::milli>(now - _requestTime).count();
+    _totalFrameWaitTime += _lastFrameWaitTime;
+    ++_nbLoadedFrames;
+    PLUGIN_DEBUG("Frame " << frame << " ready after " << _lastFrameWaitTime
+                          << " ms (" << _pendingFrames.size()
+                          << " frame(s) prefetched)");
+}
 } // namespace neuron
 } // namespace neuroscience
 } // namespace circuitexplorer
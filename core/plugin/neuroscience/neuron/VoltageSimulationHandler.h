@@ -18,6 +18,12 @@
 
 #pragma once
 
+#include "CompartmentReplayFile.h"
+#include "ReplayFrameLoader.h"
+
+#include <module/ispc/render/utils/SimulationMapping.h>
+#include <plugin/neuroscience/common/SimulationFrameCache.h>
+#include <plugin/neuroscience/common/SimulationStatisticsCollector.h>
 #include <plugin/neuroscience/common/Types.h>
 
 #include <brayns/common/simulation/AbstractSimulationHandler.h>
@@ -27,6 +33,8 @@
 #include <brayns/common/types.h>
 #include <brayns/engineapi/Scene.h>
 
+#include <chrono>
+
 namespace circuitexplorer
 {
 namespace neuroscience
@@ -36,11 +44,28 @@ namespace neuron
 using namespace brayns;
 using namespace common;
 
+const uint32_t DEFAULT_PREFETCH_DEPTH = 2;
+
 /**
  * @brief The VoltageSimulationHandler class handles simulation frames for the
  * current circuit. Frames are stored in a memory mapped file that is accessed
  * according to a specified timestamp. The VoltageSimulationHandler class is in
  * charge of keeping the handle to the memory mapped file.
+ *
+ * Frames are loaded asynchronously. In order to avoid stalls during playback,
+ * the handler keeps a queue of pending loads covering the current frame and
+ * the next frames in the direction and with the step of the playback. The
+ * number of frames loaded ahead of the current one is defined by the prefetch
+ * depth. Loaded frames are also stored in the shared simulation frame cache
+ * so that revisiting a frame does not require reading the report again.
+ *
+ * Frames can also be read from a local replay file where values are quantized
+ * to 8 or 16 bits (see CompartmentReplayFile), reducing the playback I/O.
+ *
+ * When cells are loaded as somas only, the handler can be created in somas-only
+ * mode, where frames only contain the soma compartment of each cell, in the
+ * order of the cells in the report. The offset of a cell in the simulation
+ * buffer is then its index in the report.
  */
 class VoltageSimulationHandler : public AbstractSimulationHandler
 {
@@ -50,10 +75,16 @@ public:
      * @param geometryParameters Geometry parameters
      * @param reportSource path to report source
      * @param gids GIDS to load
+     * @param synchronousMode Waits for frames to be loaded if true
+     * @param prefetchDepth Number of frames loaded ahead of the current one
+     * @param somasOnly Only keep the soma compartment of each cell
      */
     VoltageSimulationHandler(const std::string& reportPath,
                              const brion::GIDSet& gids,
-                             const bool synchronousMode = false);
+                             const bool synchronousMode = false,
+                             const uint32_t prefetchDepth =
+                                 DEFAULT_PREFETCH_DEPTH,
+                             const bool somasOnly = false);
     VoltageSimulationHandler(const VoltageSimulationHandler& rhs);
     ~VoltageSimulationHandler();
 
@@ -62,22 +93,116 @@ public:
     const std::string& getReportPath() const { return _reportPath; }
     CompartmentReportPtr getReport() const { return _compartmentReport; }
     bool isSynchronized() const { return _synchronousMode; }
+    bool isSomasOnly() const { return _somasOnly; }
     bool isReady() const final;
 
+    uint32_t getPrefetchDepth() const { return _prefetchDepth; }
+    void setPrefetchDepth(const uint32_t value) { _prefetchDepth = value; }
+
+    /**
+     * @brief Time in milliseconds between the request of the last loaded frame
+     * and the moment it became available to the renderer
+     */
+    double getLastFrameWaitTime() const { return _lastFrameWaitTime; }
+
+    /**
+     * @brief Average time in milliseconds spent waiting for frames since the
+     * creation of the handler
+     */
+    double getAverageFrameWaitTime() const;
+
+    /**
+     * @brief Number of frames that were made available to the renderer since
+     * the creation of the handler
+     */
+    uint64_t getNbLoadedFrames() const { return _nbLoadedFrames; }
+
+    /**
+     * @brief Returns the statistics of a frame, computed in the background
+     * once the frame has been loaded
+     * @return True if the statistics of the frame are available
+     */
+    bool getFrameStatistics(const uint32_t frame,
+                            SimulationFrameStatistics& statistics) const;
+
+    /**
+     * @brief Creates a quantized replay file from the compartment report. The
+     * file is not used for the playback until setReplayFile is called. This
+     * function can be called from a background thread
+     * @param path Path to the replay file
+     * @param bitsPerValue Number of bits per quantized value (8 or 16)
+     * @param perFrameScaling Quantize values within the range of each frame
+     * @param range Range of values used when perFrameScaling is false
+     * @param progress Optional function receiving the progress of the
+     * creation, from 0 to 1
+     * @return The error introduced by the quantization
+     */
+    ReplayQuantizationError createReplayFile(
+        const std::string& path, const uint8_t bitsPerValue,
+        const bool perFrameScaling, const Vector2f& range,
+        const CompartmentReplayFile::ProgressCallback& progress = {}) const;
+
+    /**
+     * @brief Uses an existing replay file for the playback. An empty path
+     * reverts to the compartment report.
+     */
+    void setReplayFile(const std::string& path);
+    std::string getReplayFile() const
+    {
+        return _replayFile ? _replayFile->getPath() : std::string();
+    }
+
+    /**
+     * @brief Keeps the mappings of the meshes to the simulation model alive as
+     * long as the handler
+     */
+    void setSimulationMappings(const SimulationMappings& mappings)
+    {
+        _simulationMappings = mappings;
+    }
+
     AbstractSimulationHandlerPtr clone() const final;
 
 private:
+    float _getTimestamp(const uint32_t frame) const;
     void _triggerLoading(const uint32_t frame);
-    bool _isFrameLoaded() const;
+    void _prefetch(const uint32_t frame);
+    bool _isFrameLoaded(const std::future<brion::Frame>& future) const;
     bool _makeFrameReady(const uint32_t frame);
+    void _setFrameReady(const uint32_t frame);
+    void _extractSomas(const floats& frame, floats& somas) const;
+    void _clearMissingSomas(floats& somas) const;
     bool _synchronousMode{false};
 
     std::string _reportPath;
     CompartmentReportPtr _compartmentReport;
-    std::future<brion::Frame> _currentFrameFuture;
-    std::map<uint64_t, std::vector<float>> _frames;
+    CompartmentReplayFilePtr _replayFile;
+    ReplayFrameLoaderPtr _replayLoader;
+    bool _somasOnly{false};
+    std::vector<uint64_t> _somaOffsets;
+    uint64_t _cacheSourceId{0};
+    std::map<uint32_t, std::future<brion::Frame>> _pendingFrames;
     uint64_t _startFrame{0};
     bool _ready{false};
+
+    // Buffer of the frame currently handed over to the renderer. It is shared
+    // with the frame cache and released when the next frame is ready.
+    FrameBufferPtr _frameBuffer;
+    SimulationStatisticsCollectorPtr _statisticsCollector;
+
+    // Mappings of the meshes to the simulation model built for the report
+    SimulationMappings _simulationMappings;
+
+    // Playback tracking
+    uint32_t _prefetchDepth{DEFAULT_PREFETCH_DEPTH};
+    uint32_t _requestedFrame{std::numeric_limits<uint32_t>::max()};
+    int64_t _playbackStep{1};
+
+    // Frame wait statistics
+    std::chrono::high_resolution_clock::time_point _requestTime;
+    double _lastFrameWaitTime{0.0};
+    double _totalFrameWaitTime{0.0};
+    uint64_t _nbLoadedFrames{0};
 };
 using VoltageSimulationHandlerPtr = std::shared_ptr<VoltageSimulationHandler>;
 } // namespace neuron
@@ -0,0 +1,435 @@
+/* Copyright (c) 2015-2018, EPFL/Blue Brain Project
+ * All rights reserved. Do not distribute without permission.
+ * Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * Checks the distances computed by the proximity analysis. The closest points
+ * of two segments are checked against a fine sampling of the segments, and
+ * the distances found with the acceleration grid against a test of all pairs
+ * of capsules. The analysis depends on OSPRay, the functions below therefore
+ * mirror, line for line, getClosestPoints and
+ * ProximityAnalysis::_computeDistances (module/ispc/render/utils/
+ * ProximityAnalysis.cpp), and must be kept in sync with them.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace
+{
+struct vec3f
+{
+    float x, y, z;
+    float operator[](const size_t i) const
+    {
+        return i == 0 ? x : (i == 1 ? y : z);
+    }
+};
+
+struct vec3i
+{
+    int x, y, z;
+};
+
+vec3f operator+(const vec3f& a, const vec3f& b)
+{
+    return {a.x + b.x, a.y + b.y, a.z + b.z};
+}
+
+vec3f operator-(const vec3f& a, const vec3f& b)
+{
+    return {a.x - b.x, a.y - b.y, a.z - b.z};
+}
+
+vec3f operator*(const float s, const vec3f& a)
+{
+    return {s * a.x, s * a.y, s * a.z};
+}
+
+vec3f operator/(const vec3f& a, const float s)
+{
+    return {a.x / s, a.y / s, a.z / s};
+}
+
+float dot(const vec3f& a, const vec3f& b)
+{
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+float length(const vec3f& a)
+{
+    return std::sqrt(dot(a, a));
+}
+
+vec3f min(const vec3f& a, const vec3f& b)
+{
+    return {std::min(a.x, b.x), std::min(a.y, b.y), std::min(a.z, b.z)};
+}
+
+vec3f max(const vec3f& a, const vec3f& b)
+{
+    return {std::max(a.x, b.x), std::max(a.y, b.y), std::max(a.z, b.z)};
+}
+
+float reduce_max(const vec3f& a)
+{
+    return std::max(a.x, std::max(a.y, a.z));
+}
+
+struct box3f
+{
+    vec3f lower;
+    vec3f upper;
+    vec3f size() const { return upper - lower; }
+    void extend(const box3f& b)
+    {
+        lower = min(lower, b.lower);
+        upper = max(upper, b.upper);
+    }
+};
+
+struct Capsule
+{
+    vec3f p0;
+    vec3f p1;
+    float r0;
+    float r1;
+    const void* group;
+};
+
+// Maximum number of cells of the acceleration grid along one axis
+const int MAX_GRID_RESOLUTION = 256;
+
+bool overlap(const box3f& a, const box3f& b)
+{
+    return a.lower.x <= b.upper.x && b.lower.x <= a.upper.x &&
+           a.lower.y <= b.upper.y && b.lower.y <= a.upper.y &&
+           a.lower.z <= b.upper.z && b.lower.z <= a.upper.z;
+}
+
+// Parameters of the closest points of segments [p0, p1] and [q0, q1]
+void getClosestPoints(const vec3f& p0, const vec3f& p1, const vec3f& q0,
+                      const vec3f& q1, float& s, float& t)
+{
+    const vec3f d1 = p1 - p0;
+    const vec3f d2 = q1 - q0;
+    const vec3f r = p0 - q0;
+    const float a = dot(d1, d1);
+    const float e = dot(d2, d2);
+    const float f = dot(d2, r);
+    const float epsilon = 1e-12f;
+
+    if (a <= epsilon && e <= epsilon)
+    {
+        s = t = 0.f;
+        return;
+    }
+    if (a <= epsilon)
+    {
+        s = 0.f;
+        t = std::min(1.f, std::max(0.f, f / e));
+        return;
+    }
+
+    const float c = dot(d1, r);
+    if (e <= epsilon)
+    {
+        t = 0.f;
+        s = std::min(1.f, std::max(0.f, -c / a));
+        return;
+    }
+
+    const float b = dot(d1, d2);
+    const float denominator = a * e - b * b;
+    s = denominator > epsilon
+            ? std::min(1.f, std::max(0.f, (b * f - c * e) / denominator))
+            : 0.f;
+    t = (b * s + f) / e;
+    if (t < 0.f)
+    {
+        t = 0.f;
+        s = std::min(1.f, std::max(0.f, -c / a));
+    }
+    else if (t > 1.f)
+    {
+        t = 1.f;
+        s = std::min(1.f, std::max(0.f, (b - c) / a));
+    }
+}
+
+float getCapsuleDistance(const Capsule& capsule, const Capsule& other)
+{
+    float s, t;
+    getClosestPoints(capsule.p0, capsule.p1, other.p0, other.p1, s, t);
+    const auto p = capsule.p0 + s * (capsule.p1 - capsule.p0);
+    const auto q = other.p0 + t * (other.p1 - other.p0);
+    const float radii = capsule.r0 + s * (capsule.r1 - capsule.r0) + other.r0 +
+                        t * (other.r1 - other.r0);
+    return length(p - q) - radii;
+}
+
+std::vector<float> computeDistances(const std::vector<Capsule>& capsules,
+                                    const float distance)
+{
+    const size_t nbCapsules = capsules.size();
+    std::vector<float> distances(nbCapsules,
+                                 std::numeric_limits<float>::infinity());
+    if (nbCapsules == 0)
+        return distances;
+
+    // Bounding boxes, expanded by half the detection distance so that two
+    // capsules closer than that distance have overlapping boxes
+    const float margin = 0.5f * distance;
+    std::vector<box3f> bounds(nbCapsules);
+    float averageExtent = 0.f;
+    for (size_t i = 0; i < nbCapsules; ++i)
+    {
+        const auto& capsule = capsules[i];
+        const vec3f r0{capsule.r0 + margin, capsule.r0 + margin,
+                       capsule.r0 + margin};
+        const vec3f r1{capsule.r1 + margin, capsule.r1 + margin,
+                       capsule.r1 + margin};
+        bounds[i] = {min(capsule.p0 - r0, capsule.p1 - r1),
+                     max(capsule.p0 + r0, capsule.p1 + r1)};
+        averageExtent += reduce_max(bounds[i].size());
+    }
+    averageExtent /= nbCapsules;
+
+    box3f sceneBounds = bounds[0];
+    for (const auto& box : bounds)
+        sceneBounds.extend(box);
+
+    // Uniform grid of the bounding boxes, sized after the average primitive
+    const vec3f sceneSize = sceneBounds.size();
+    const float cellSize =
+        std::max(std::max(1e-6f, averageExtent),
+                 reduce_max(sceneSize) / MAX_GRID_RESOLUTION);
+    int dimensions[3];
+    for (size_t i = 0; i < 3; ++i)
+        dimensions[i] = std::max(
+            1, std::min(MAX_GRID_RESOLUTION,
+                        int(std::ceil(sceneSize[i] / cellSize))));
+
+    const auto getCell = [&](const vec3f& p)
+    {
+        const auto c = (p - sceneBounds.lower) / cellSize;
+        return vec3i{std::min(int(c.x), dimensions[0] - 1),
+                     std::min(int(c.y), dimensions[1] - 1),
+                     std::min(int(c.z), dimensions[2] - 1)};
+    };
+    const auto getCellIndex = [&](const int x, const int y, const int z)
+    { return size_t(x) + dimensions[0] * (size_t(y) + dimensions[1] * z); };
+
+    // Counting sort of the capsules by overlapped cell
+    const size_t nbCells =
+        size_t(dimensions[0]) * dimensions[1] * dimensions[2];
+    std::vector<vec3i> lowerCells(nbCapsules);
+    std::vector<vec3i> upperCells(nbCapsules);
+    std::vector<size_t> cellOffsets(nbCells + 1, 0);
+    for (size_t i = 0; i < nbCapsules; ++i)
+    {
+        const auto& lo = lowerCells[i] = getCell(bounds[i].lower);
+        const auto& hi = upperCells[i] = getCell(bounds[i].upper);
+        for (int z = lo.z; z <= hi.z; ++z)
+            for (int y = lo.y; y <= hi.y; ++y)
+                for (int x = lo.x; x <= hi.x; ++x)
+                    ++cellOffsets[getCellIndex(x, y, z) + 1];
+    }
+    for (size_t i = 0; i < nbCells; ++i)
+        cellOffsets[i + 1] += cellOffsets[i];
+
+    std::vector<uint32_t> cellCapsules(cellOffsets.back());
+    std::vector<size_t> cursors(cellOffsets.begin(), cellOffsets.end() - 1);
+    for (size_t i = 0; i < nbCapsules; ++i)
+    {
+        const auto& lo = lowerCells[i];
+        const auto& hi = upperCells[i];
+        for (int z = lo.z; z <= hi.z; ++z)
+            for (int y = lo.y; y <= hi.y; ++y)
+                for (int x = lo.x; x <= hi.x; ++x)
+                    cellCapsules[cursors[getCellIndex(x, y, z)]++] = i;
+    }
+
+    // Capsules are independent from each other. A pair of capsules sharing
+    // several cells is only tested in the first of them
+    for (size_t i = 0; i < nbCapsules; ++i)
+    {
+        const auto& capsule = capsules[i];
+        const auto& lo = lowerCells[i];
+        const auto& hi = upperCells[i];
+        float closest = std::numeric_limits<float>::infinity();
+        for (int z = lo.z; z <= hi.z; ++z)
+            for (int y = lo.y; y <= hi.y; ++y)
+                for (int x = lo.x; x <= hi.x; ++x)
+                {
+                    const size_t cell = getCellIndex(x, y, z);
+                    for (size_t k = cellOffsets[cell];
+                         k < cellOffsets[cell + 1]; ++k)
+                    {
+                        const auto j = cellCapsules[k];
+                        const auto& other = capsules[j];
+                        if (other.group == capsule.group)
+                            continue;
+
+                        const auto& otherLo = lowerCells[j];
+                        if (x != std::max(lo.x, otherLo.x) ||
+                            y != std::max(lo.y, otherLo.y) ||
+                            z != std::max(lo.z, otherLo.z))
+                            continue;
+                        if (!overlap(bounds[i], bounds[j]))
+                            continue;
+
+                        closest = std::min(closest,
+                                           getCapsuleDistance(capsule, other));
+                    }
+                }
+        if (closest <= distance)
+            distances[i] = std::max(0.f, closest);
+    }
+    return distances;
+}
+
+// Distance between two segments, by fine sampling of both of them
+float bruteForceSegmentDistance(const vec3f& p0, const vec3f& p1,
+                                const vec3f& q0, const vec3f& q1)
+{
+    const size_t nbSamples = 400;
+    float closest = std::numeric_limits<float>::infinity();
+    for (size_t i = 0; i <= nbSamples; ++i)
+        for (size_t j = 0; j <= nbSamples; ++j)
+        {
+            const float s = float(i) / nbSamples;
+            const float t = float(j) / nbSamples;
+            closest = std::min(closest, length((p0 + s * (p1 - p0)) -
+                                               (q0 + t * (q1 - q0))));
+        }
+    return closest;
+}
+
+// Deterministic pseudo-random numbers in [0, 1)
+float random(uint32_t& seed)
+{
+    seed = seed * 1664525u + 1013904223u;
+    return float(seed >> 8) / float(1u << 24);
+}
+
+vec3f randomPoint(uint32_t& seed, const float extent)
+{
+    const float x = random(seed);
+    const float y = random(seed);
+    const float z = random(seed);
+    return extent * vec3f{x, y, z};
+}
+
+bool check(const std::string& name, const float value, const float expected,
+           const float tolerance)
+{
+    if (std::abs(value - expected) <= tolerance ||
+        (std::isinf(value) && std::isinf(expected)))
+        return true;
+    std::cerr << name << ": got " << value << ", expected " << expected
+              << std::endl;
+    return false;
+}
+} // namespace
+
+int main()
+{
+    bool success = true;
+
+    // Closest points of segments, including degenerate and parallel ones
+    struct Segments
+    {
+        std::string name;
+        vec3f p0, p1, q0, q1;
+    };
+    const std::vector<Segments> segments = {
+        {"Crossing", {-1, 0, 0}, {1, 0, 0}, {0, -1, 1}, {0, 1, 1}},
+        {"Parallel", {0, 0, 0}, {2, 0, 0}, {1, 1, 0}, {3, 1, 0}},
+        {"Collinear", {0, 0, 0}, {1, 0, 0}, {2, 0, 0}, {3, 0, 0}},
+        {"Points", {1, 2, 3}, {1, 2, 3}, {4, 6, 3}, {4, 6, 3}},
+        {"Point and segment", {0, 0, 0}, {0, 0, 0}, {-1, 1, 0}, {1, 1, 0}},
+        {"Segment and point", {-1, 1, 0}, {1, 1, 0}, {3, 0, 0}, {3, 0, 0}},
+        {"Skew", {0, 0, 0}, {1, 1, 0}, {2, 0, 1}, {3, -2, 4}}};
+    for (const auto& segment : segments)
+    {
+        float s, t;
+        getClosestPoints(segment.p0, segment.p1, segment.q0, segment.q1, s, t);
+        const float distance =
+            length((segment.p0 + s * (segment.p1 - segment.p0)) -
+                   (segment.q0 + t * (segment.q1 - segment.q0)));
+        success &= check(segment.name, distance,
+                         bruteForceSegmentDistance(segment.p0, segment.p1,
+                                                   segment.q0, segment.q1),
+                         1e-2f);
+    }
+
+    // Distances between capsules subtract their radii at the closest points
+    const int groupA = 0, groupB = 0;
+    const Capsule sphere{{0, 0, 0}, {0, 0, 0}, 1.f, 1.f, &groupA};
+    const Capsule cylinder{{-5, 3, 0}, {5, 3, 0}, 0.5f, 0.5f, &groupB};
+    const Capsule cone{{4, 0, 0}, {8, 0, 0}, 2.f, 0.f, &groupB};
+    success &= check("Sphere and cylinder",
+                     getCapsuleDistance(sphere, cylinder), 1.5f, 1e-5f);
+    success &= check("Sphere and cone", getCapsuleDistance(sphere, cone), 1.f,
+                     1e-5f);
+
+    // Distances found with the acceleration grid match the ones of all pairs
+    // of capsules, whatever the size of the primitives
+    uint32_t seed = 7;
+    const int groups[3] = {0, 0, 0};
+    std::vector<Capsule> capsules;
+    for (size_t i = 0; i < 600; ++i)
+    {
+        const auto p0 = randomPoint(seed, 100.f);
+        const float size = (i % 50 == 0 ? 40.f : 4.f);
+        const auto p1 = p0 + randomPoint(seed, size);
+        const float r0 = 0.5f * random(seed);
+        const float r1 = (i % 3 == 0 ? r0 : 0.5f * random(seed));
+        capsules.push_back({p0, i % 4 == 0 ? p0 : p1, r0, r1, &groups[i % 3]});
+    }
+    for (const float detectionDistance : {0.5f, 3.f, 10.f})
+    {
+        const auto distances = computeDistances(capsules, detectionDistance);
+        for (size_t i = 0; i < capsules.size(); ++i)
+        {
+            float closest = std::numeric_limits<float>::infinity();
+            for (size_t j = 0; j < capsules.size(); ++j)
+                if (capsules[j].group != capsules[i].group)
+                    closest = std::min(closest, getCapsuleDistance(
+                                                    capsules[i], capsules[j]));
+            const float expected =
+                (closest <= detectionDistance
+                     ? std::max(0.f, closest)
+                     : std::numeric_limits<float>::infinity());
+            success &= check("Capsule " + std::to_string(i) + " within " +
+                                 std::to_string(detectionDistance),
+                             distances[i], expected, 1e-5f);
+        }
+    }
+
+    if (!success)
+        return EXIT_FAILURE;
+    std::cout << "Proximity distances match brute force" << std::endl;
+    return EXIT_SUCCESS;
+}
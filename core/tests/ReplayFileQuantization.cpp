@@ -0,0 +1,214 @@
+/* Copyright (c) 2015-2018, EPFL/Blue Brain Project
+ * All rights reserved. Do not distribute without permission.
+ * Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * Checks the round-trip of simulation values through the quantization of the
+ * voltage replay files. The replay file depends on Brayns, the functions below
+ * therefore mirror, line for line:
+ * - quantize and dequantize
+ * - the range of a frame computed by CompartmentReplayFile::create when values
+ *   are scaled per frame
+ * (plugin/neuroscience/neuron/CompartmentReplayFile.cpp) and must be kept in
+ * sync with them.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace
+{
+using floats = std::vector<float>;
+
+template <typename T>
+void quantize(const floats& values, const float minValue, const float maxValue,
+              uint8_t* output, double& maxError, double& sumSquaredErrors)
+{
+    const float maxQuantizedValue = std::numeric_limits<T>::max();
+    const float range = maxValue - minValue;
+    const float scale = (range > 0.f ? maxQuantizedValue / range : 0.f);
+    const float invScale = (range > 0.f ? range / maxQuantizedValue : 0.f);
+    T* quantizedValues = reinterpret_cast<T*>(output);
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        // Missing values cannot be stored and are left to the caller
+        if (std::isnan(values[i]))
+        {
+            quantizedValues[i] = 0;
+            continue;
+        }
+        const float value = std::min(maxValue, std::max(minValue, values[i]));
+        const T quantizedValue =
+            static_cast<T>(std::round((value - minValue) * scale));
+        quantizedValues[i] = quantizedValue;
+
+        const double error =
+            std::abs(minValue + quantizedValue * invScale - values[i]);
+        maxError = std::max(maxError, error);
+        sumSquaredErrors += error * error;
+    }
+}
+
+template <typename T>
+void dequantize(const uint8_t* input, const float minValue,
+                const float maxValue, floats& values)
+{
+    const float maxQuantizedValue = std::numeric_limits<T>::max();
+    const float invScale = (maxValue - minValue) / maxQuantizedValue;
+    const T* quantizedValues = reinterpret_cast<const T*>(input);
+    for (size_t i = 0; i < values.size(); ++i)
+        values[i] = minValue + quantizedValues[i] * invScale;
+}
+
+void getFrameRange(const floats& values, float& minValue, float& maxValue)
+{
+    // Missing values (NaN) do not contribute to the range
+    minValue = std::numeric_limits<float>::max();
+    maxValue = -std::numeric_limits<float>::max();
+    for (const auto value : values)
+    {
+        if (std::isnan(value))
+            continue;
+        minValue = std::min(minValue, value);
+        maxValue = std::max(maxValue, value);
+    }
+    if (minValue > maxValue)
+        minValue = maxValue = 0.f;
+}
+
+// Quantizes and decodes a frame, returning the decoded values and the maximum
+// error reported by the quantization
+template <typename T>
+floats roundTrip(const floats& values, const float minValue,
+                 const float maxValue, double& maxError)
+{
+    std::vector<uint8_t> buffer(values.size() * sizeof(T));
+    double sumSquaredErrors = 0.0;
+    maxError = 0.0;
+    quantize<T>(values, minValue, maxValue, buffer.data(), maxError,
+                sumSquaredErrors);
+    floats decoded(values.size());
+    dequantize<T>(buffer.data(), minValue, maxValue, decoded);
+    return decoded;
+}
+
+bool check(const std::string& name, const bool value)
+{
+    if (!value)
+        std::cerr << name << " failed" << std::endl;
+    return value;
+}
+
+// Checks that decoded values are within half a quantization step of the
+// original values, clamped to the range, and that the reported error is the
+// actual one
+template <typename T>
+bool checkRoundTrip(const std::string& name, const floats& values,
+                    const float minValue, const float maxValue)
+{
+    double maxError;
+    const auto decoded = roundTrip<T>(values, minValue, maxValue, maxError);
+    const double step =
+        (maxValue - minValue) / double(std::numeric_limits<T>::max());
+    const double tolerance = 0.5 * step + 1e-5 * (1.0 + std::abs(maxValue));
+
+    bool success = true;
+    double actualMaxError = 0.0;
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        const float clamped = std::min(maxValue, std::max(minValue, values[i]));
+        if (std::abs(decoded[i] - clamped) > tolerance)
+        {
+            std::cerr << name << ": value " << values[i] << " decoded as "
+                      << decoded[i] << std::endl;
+            success = false;
+        }
+        actualMaxError =
+            std::max(actualMaxError, double(std::abs(decoded[i] - values[i])));
+    }
+    success &= check(name + ", reported error",
+                     std::abs(maxError - actualMaxError) <= tolerance);
+    return success;
+}
+} // namespace
+
+int main()
+{
+    // Voltage-like values, with some outside of the fixed range
+    floats values;
+    for (size_t i = 0; i < 1000; ++i)
+    {
+        const float s = std::sin(0.37f * i);
+        values.push_back(-85.f + 80.f * s * s);
+    }
+
+    bool success = true;
+    success &= checkRoundTrip<uint8_t>("8 bits, fixed range", values, -80.f,
+                                       -10.f);
+    success &= checkRoundTrip<uint16_t>("16 bits, fixed range", values, -80.f,
+                                        -10.f);
+
+    float minValue, maxValue;
+    getFrameRange(values, minValue, maxValue);
+    success &= check("Frame range",
+                     minValue == *std::min_element(values.begin(),
+                                                   values.end()) &&
+                         maxValue == *std::max_element(values.begin(),
+                                                       values.end()));
+    success &= checkRoundTrip<uint8_t>("8 bits, per-frame scaling", values,
+                                       minValue, maxValue);
+    success &= checkRoundTrip<uint16_t>("16 bits, per-frame scaling", values,
+                                        minValue, maxValue);
+
+    // Frames of constant values are decoded exactly
+    const floats constant(16, -65.f);
+    getFrameRange(constant, minValue, maxValue);
+    double maxError;
+    const auto decodedConstant =
+        roundTrip<uint16_t>(constant, minValue, maxValue, maxError);
+    success &= check("Constant frame", decodedConstant == constant &&
+                                           maxError == 0.0);
+
+    // Missing values do not contribute to the range nor to the error, and
+    // are decoded as the minimum of the range
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    const floats missing = {nan, -70.f, nan, -20.f};
+    getFrameRange(missing, minValue, maxValue);
+    success &= check("Range with missing values",
+                     minValue == -70.f && maxValue == -20.f);
+    const auto decodedMissing =
+        roundTrip<uint8_t>(missing, minValue, maxValue, maxError);
+    success &= check("Missing values", decodedMissing[0] == minValue &&
+                                           decodedMissing[2] == minValue &&
+                                           !std::isnan(maxError) &&
+                                           maxError < 1e-4);
+    getFrameRange({nan, nan}, minValue, maxValue);
+    success &= check("Range of missing values only",
+                     minValue == 0.f && maxValue == 0.f);
+
+    if (!success)
+        return EXIT_FAILURE;
+    std::cout << "Replay file quantization round-trips within half a step"
+              << std::endl;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,238 @@
+/* Copyright (c) 2015-2018, EPFL/Blue Brain Project
+ * All rights reserved. Do not distribute without permission.
+ * Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * Checks the least-recently-used eviction of the simulation frame cache under
+ * a memory budget. The cache depends on Brayns, the class below therefore
+ * mirrors, line for line, the get, put, setBudget and _evict functions of
+ * SimulationFrameCache (plugin/neuroscience/common/SimulationFrameCache.cpp),
+ * without locking nor statistics, and must be kept in sync with them.
+ */
+
+#include <cstdlib>
+#include <iostream>
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+using floats = std::vector<float>;
+using FrameBufferPtr = std::shared_ptr<floats>;
+
+class SimulationFrameCache
+{
+public:
+    void setBudget(const size_t bytes)
+    {
+        if (bytes == _budget)
+            return;
+        _budget = bytes;
+        _evict(0);
+    }
+
+    FrameBufferPtr get(const uint64_t sourceId, const uint32_t frame)
+    {
+        FrameBufferPtr data{nullptr};
+        const auto it = _index.find({sourceId, frame});
+        if (it != _index.end())
+        {
+            // Move entry to the front of the list (most recently used)
+            _entries.splice(_entries.begin(), _entries, it->second);
+            data = it->second->data;
+        }
+        return data;
+    }
+
+    void put(const uint64_t sourceId, const uint32_t frame,
+             const FrameBufferPtr& data)
+    {
+        if (!data)
+            return;
+        const size_t bytes = data->size() * sizeof(float);
+        if (bytes == 0 || bytes > _budget)
+            return;
+
+        const Key key{sourceId, frame};
+        const auto it = _index.find(key);
+        if (it != _index.end())
+        {
+            _size -= it->second->data->size() * sizeof(float);
+            _entries.erase(it->second);
+            _index.erase(it);
+        }
+
+        _evict(bytes);
+        _entries.push_front({key, data});
+        _index[key] = _entries.begin();
+        _size += bytes;
+    }
+
+    bool contains(const uint64_t sourceId, const uint32_t frame) const
+    {
+        return _index.find({sourceId, frame}) != _index.end();
+    }
+
+    size_t getSize() const { return _size; }
+
+private:
+    using Key = std::pair<uint64_t, uint32_t>;
+    struct Entry
+    {
+        Key key;
+        FrameBufferPtr data;
+    };
+    using Entries = std::list<Entry>;
+
+    void _evict(const size_t requiredBytes)
+    {
+        while (!_entries.empty() && _size + requiredBytes > _budget)
+        {
+            const auto& entry = _entries.back();
+            _size -= entry.data->size() * sizeof(float);
+            _index.erase(entry.key);
+            _entries.pop_back();
+        }
+    }
+
+    Entries _entries; // Most recently used first
+    std::map<Key, Entries::iterator> _index;
+    size_t _budget{1024ull * 1024ull * 1024ull};
+    size_t _size{0};
+};
+
+FrameBufferPtr makeFrame(const size_t nbValues, const float value)
+{
+    return std::make_shared<floats>(nbValues, value);
+}
+
+bool check(const std::string& name, const bool value)
+{
+    if (!value)
+        std::cerr << name << " failed" << std::endl;
+    return value;
+}
+
+bool checkContents(const std::string& name, const SimulationFrameCache& cache,
+                   const uint64_t sourceId,
+                   const std::vector<uint32_t>& expected,
+                   const uint32_t nbFrames)
+{
+    bool success = true;
+    for (uint32_t frame = 0; frame < nbFrames; ++frame)
+    {
+        bool isExpected = false;
+        for (const auto e : expected)
+            isExpected |= (e == frame);
+        success &= check(name + ", frame " + std::to_string(frame),
+                         cache.contains(sourceId, frame) == isExpected);
+    }
+    return success;
+}
+} // namespace
+
+int main()
+{
+    bool success = true;
+    const size_t frameBytes = 4 * sizeof(float);
+
+    {
+        // Frames are evicted in least recently used order, a lookup making a
+        // frame the most recently used one
+        SimulationFrameCache cache;
+        cache.setBudget(3 * frameBytes);
+        for (uint32_t frame = 0; frame < 3; ++frame)
+            cache.put(0, frame, makeFrame(4, frame));
+        success &= check("Lookup of frame 0", cache.get(0, 0) != nullptr);
+        cache.put(0, 3, makeFrame(4, 3));
+        success &= checkContents("Eviction after lookup", cache, 0, {0, 2, 3},
+                                 4);
+        success &= check("Size within budget",
+                         cache.getSize() == 3 * frameBytes);
+    }
+
+    {
+        // Frames of different sources do not collide
+        SimulationFrameCache cache;
+        cache.put(0, 7, makeFrame(4, 1.f));
+        cache.put(1, 7, makeFrame(4, 2.f));
+        const auto first = cache.get(0, 7);
+        const auto second = cache.get(1, 7);
+        success &= check("Sources are distinct",
+                         first && second && (*first)[0] == 1.f &&
+                             (*second)[0] == 2.f);
+    }
+
+    {
+        // Storing a frame again replaces it without counting it twice
+        SimulationFrameCache cache;
+        cache.setBudget(2 * frameBytes);
+        cache.put(0, 0, makeFrame(4, 1.f));
+        cache.put(0, 0, makeFrame(4, 2.f));
+        success &= check("Replaced frame size", cache.getSize() == frameBytes);
+        const auto data = cache.get(0, 0);
+        success &= check("Replaced frame value", data && (*data)[0] == 2.f);
+    }
+
+    {
+        // Frames larger than the budget are not stored, and do not evict the
+        // frames already in the cache
+        SimulationFrameCache cache;
+        cache.setBudget(2 * frameBytes);
+        cache.put(0, 0, makeFrame(4, 0.f));
+        cache.put(0, 1, makeFrame(12, 0.f));
+        success &= checkContents("Frame larger than the budget", cache, 0, {0},
+                                 2);
+    }
+
+    {
+        // Lowering the budget evicts the least recently used frames, a budget
+        // of zero disables the cache
+        SimulationFrameCache cache;
+        cache.setBudget(4 * frameBytes);
+        for (uint32_t frame = 0; frame < 4; ++frame)
+            cache.put(0, frame, makeFrame(4, frame));
+        cache.get(0, 1);
+        cache.setBudget(2 * frameBytes);
+        success &= checkContents("Lowered budget", cache, 0, {1, 3}, 4);
+        cache.setBudget(0);
+        success &= checkContents("Zero budget", cache, 0, {}, 4);
+        cache.put(0, 0, makeFrame(4, 0.f));
+        success &= check("Disabled cache", !cache.contains(0, 0));
+    }
+
+    {
+        // Evicted buffers remain valid for the handlers still using them
+        SimulationFrameCache cache;
+        cache.setBudget(frameBytes);
+        auto data = makeFrame(4, 5.f);
+        cache.put(0, 0, data);
+        cache.put(0, 1, makeFrame(4, 6.f));
+        success &= check("Evicted buffer", !cache.contains(0, 0) &&
+                                               data.use_count() == 1 &&
+                                               (*data)[0] == 5.f);
+    }
+
+    if (!success)
+        return EXIT_FAILURE;
+    std::cout << "Simulation frame cache evicts least recently used frames"
+              << std::endl;
+    return EXIT_SUCCESS;
+}
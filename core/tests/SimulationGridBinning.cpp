@@ -0,0 +1,364 @@
+/* Copyright (c) 2015-2018, EPFL/Blue Brain Project
+ * All rights reserved. Do not distribute without permission.
+ * Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * Checks the binning of primitives into the simulation grid of the voxelized
+ * simulation renderer, and the colors splatted into its cells. The grid
+ * depends on OSPRay, the functions below therefore mirror, line for line,
+ * addPrimitives, SimulationGrid::_assignPrimitives and SimulationGrid::splat
+ * (module/ispc/render/utils/SimulationGrid.cpp), and must be kept in sync
+ * with them.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace
+{
+struct vec3f
+{
+    float x, y, z;
+    float operator[](const size_t i) const
+    {
+        return i == 0 ? x : (i == 1 ? y : z);
+    }
+};
+
+struct vec4f
+{
+    float x, y, z, w;
+};
+
+vec3f operator-(const vec3f& a, const vec3f& b)
+{
+    return {a.x - b.x, a.y - b.y, a.z - b.z};
+}
+
+vec3f operator/(const vec3f& a, const float s)
+{
+    return {a.x / s, a.y / s, a.z / s};
+}
+
+vec3f min(const vec3f& a, const vec3f& b)
+{
+    return {std::min(a.x, b.x), std::min(a.y, b.y), std::min(a.z, b.z)};
+}
+
+vec3f max(const vec3f& a, const vec3f& b)
+{
+    return {std::max(a.x, b.x), std::max(a.y, b.y), std::max(a.z, b.z)};
+}
+
+// Primitive of a geometry, as stored by Brayns
+struct Sphere
+{
+    vec3f center;
+    float radius;
+    uint64_t userData;
+};
+
+struct Primitive
+{
+    vec3f position;
+    uint64_t offset;
+};
+
+struct Cell
+{
+    size_t index;
+    size_t begin;
+    size_t end;
+};
+
+// Adds the primitives of a geometry, positioned at their center and carrying
+// the simulation offset of their userData member. Geometries that are not
+// attached to a simulation leave the userData of all their primitives to 0,
+// they are skipped rather than colored with the first simulation value
+void addPrimitives(const std::vector<Sphere>& items,
+                   std::vector<Primitive>& primitives)
+{
+    if (std::all_of(items.begin(), items.end(),
+                    [](const Sphere& item) { return item.userData == 0; }))
+        return;
+
+    for (size_t i = 0; i < items.size(); ++i)
+        primitives.push_back({items[i].center, items[i].userData});
+}
+
+struct SimulationGrid
+{
+    int dimensions[3]{0, 0, 0};
+    vec3f lower{0.f, 0.f, 0.f};
+    float cellSize{0.f};
+    std::vector<Cell> cells;
+    std::vector<uint64_t> offsets;
+    std::vector<vec4f> colors;
+
+    void assignPrimitives(const std::vector<Primitive>& primitives,
+                          const uint32_t resolution)
+    {
+        cells.clear();
+        offsets.clear();
+        colors.clear();
+        dimensions[0] = dimensions[1] = dimensions[2] = 0;
+        if (primitives.empty() || resolution == 0)
+            return;
+
+        vec3f lo = primitives[0].position;
+        vec3f upper = lo;
+        for (const auto& primitive : primitives)
+        {
+            lo = min(lo, primitive.position);
+            upper = max(upper, primitive.position);
+        }
+        const vec3f extent = upper - lo;
+        cellSize = std::max(
+            1e-6f,
+            std::max(extent.x, std::max(extent.y, extent.z)) / resolution);
+        lower = lo;
+        for (size_t i = 0; i < 3; ++i)
+            dimensions[i] =
+                std::max(1, std::min(int(resolution),
+                                     int(std::ceil(extent[i] / cellSize))));
+
+        // Counting sort of the primitives by cell
+        const size_t nbCells =
+            size_t(dimensions[0]) * dimensions[1] * dimensions[2];
+        std::vector<size_t> cellIndices(primitives.size());
+        std::vector<size_t> cellOffsets(nbCells + 1, 0);
+        for (size_t i = 0; i < primitives.size(); ++i)
+        {
+            const auto p = (primitives[i].position - lower) / cellSize;
+            const auto x = std::min(size_t(p.x), size_t(dimensions[0] - 1));
+            const auto y = std::min(size_t(p.y), size_t(dimensions[1] - 1));
+            const auto z = std::min(size_t(p.z), size_t(dimensions[2] - 1));
+            cellIndices[i] = x + dimensions[0] * (y + dimensions[1] * z);
+            ++cellOffsets[cellIndices[i] + 1];
+        }
+        for (size_t i = 0; i < nbCells; ++i)
+            cellOffsets[i + 1] += cellOffsets[i];
+
+        offsets.resize(primitives.size());
+        std::vector<size_t> cursors(cellOffsets.begin(), cellOffsets.end() - 1);
+        for (size_t i = 0; i < primitives.size(); ++i)
+            offsets[cursors[cellIndices[i]]++] = primitives[i].offset;
+
+        for (size_t i = 0; i < nbCells; ++i)
+            if (cellOffsets[i + 1] > cellOffsets[i])
+                cells.push_back({i, cellOffsets[i], cellOffsets[i + 1]});
+        colors.assign(nbCells, {0.f, 0.f, 0.f, 0.f});
+    }
+
+    void splat(const std::vector<float>& simulationData,
+               const std::vector<vec4f>& table, const float scale,
+               const float offset)
+    {
+        for (const auto& cell : cells)
+        {
+            float color[3] = {0.f, 0.f, 0.f};
+            float opacity = 0.f;
+            size_t nbValues = 0;
+            for (size_t j = cell.begin; j < cell.end; ++j)
+            {
+                if (offsets[j] >= simulationData.size())
+                    continue;
+                const float value = simulationData[offsets[j]];
+                if (std::isnan(value))
+                    continue;
+                const auto sample =
+                    getTransferFunctionValue(table, scale, offset, value);
+                color[0] += sample.w * sample.x;
+                color[1] += sample.w * sample.y;
+                color[2] += sample.w * sample.z;
+                opacity += sample.w;
+                ++nbValues;
+            }
+            colors[cell.index] =
+                opacity > 0.f
+                    ? vec4f{color[0] / opacity, color[1] / opacity,
+                            color[2] / opacity, opacity / nbValues}
+                    : vec4f{0.f, 0.f, 0.f, 0.f};
+        }
+    }
+
+    static vec4f getTransferFunctionValue(const std::vector<vec4f>& table,
+                                          const float scale,
+                                          const float offset, const float value)
+    {
+        const float last = table.size() - 1;
+        const float x = std::min(last, std::max(0.f, value * scale + offset));
+        const size_t index = std::min(size_t(x), table.size() - 2);
+        const float weight = x - index;
+        const auto& a = table[index];
+        const auto& b = table[index + 1];
+        return {a.x * (1.f - weight) + b.x * weight,
+                a.y * (1.f - weight) + b.y * weight,
+                a.z * (1.f - weight) + b.z * weight,
+                a.w * (1.f - weight) + b.w * weight};
+    }
+};
+
+// Deterministic pseudo-random numbers in [0, 1)
+float random(uint32_t& seed)
+{
+    seed = seed * 1664525u + 1013904223u;
+    return float(seed >> 8) / float(1u << 24);
+}
+
+bool check(const std::string& name, const bool value)
+{
+    if (!value)
+        std::cerr << name << " failed" << std::endl;
+    return value;
+}
+} // namespace
+
+int main()
+{
+    bool success = true;
+
+    // A geometry attached to the simulation, with a primitive of offset 0,
+    // and a geometry that is not attached to it
+    uint32_t seed = 3;
+    const size_t nbValues = 500;
+    std::vector<Sphere> mapped;
+    for (size_t i = 0; i < 2000; ++i)
+        mapped.push_back({{100.f * random(seed), 40.f * random(seed),
+                           10.f * random(seed)},
+                          1.f,
+                          i % nbValues});
+    const std::vector<Sphere> unmapped(100, {{500.f, 500.f, 500.f}, 1.f, 0});
+
+    std::vector<Primitive> primitives;
+    addPrimitives(mapped, primitives);
+    addPrimitives(unmapped, primitives);
+    success &= check("Unmapped geometry skipped",
+                     primitives.size() == mapped.size());
+
+    // Every primitive lands in exactly one cell, the one containing its
+    // position, cells along the largest side being bounded by the resolution
+    const uint32_t resolution = 32;
+    SimulationGrid grid;
+    grid.assignPrimitives(primitives, resolution);
+    success &= check("Dimensions", grid.dimensions[0] == int(resolution) &&
+                                       grid.dimensions[1] <= int(resolution) &&
+                                       grid.dimensions[2] <= int(resolution));
+    size_t nbBinned = 0;
+    std::vector<size_t> nbPerOffset(nbValues, 0);
+    for (const auto& cell : grid.cells)
+    {
+        const int x = cell.index % grid.dimensions[0];
+        const int y = (cell.index / grid.dimensions[0]) % grid.dimensions[1];
+        const int z = cell.index / (grid.dimensions[0] * grid.dimensions[1]);
+        for (size_t j = cell.begin; j < cell.end; ++j)
+        {
+            ++nbPerOffset[grid.offsets[j]];
+            ++nbBinned;
+        }
+
+        // Primitives carrying the offsets of the cell are inside of it
+        for (const auto& primitive : primitives)
+        {
+            const auto p = (primitive.position - grid.lower) / grid.cellSize;
+            const int px = std::min(int(p.x), grid.dimensions[0] - 1);
+            const int py = std::min(int(p.y), grid.dimensions[1] - 1);
+            const int pz = std::min(int(p.z), grid.dimensions[2] - 1);
+            if (px != x || py != y || pz != z)
+                continue;
+            bool found = false;
+            for (size_t j = cell.begin; j < cell.end && !found; ++j)
+                found = (grid.offsets[j] == primitive.offset);
+            success &= check("Primitive in cell " + std::to_string(cell.index),
+                             found);
+        }
+    }
+    success &= check("All primitives binned", nbBinned == primitives.size());
+    for (size_t i = 0; i < nbValues; ++i)
+        success &= check("Primitives of offset " + std::to_string(i),
+                         nbPerOffset[i] == primitives.size() / nbValues);
+
+    // Colors are the opacity-weighted average of the transfer function values
+    // of the primitives, missing values and values out of the frame ignored
+    const std::vector<vec4f> table = {{1.f, 0.f, 0.f, 0.2f},
+                                      {0.f, 1.f, 0.f, 0.5f},
+                                      {0.f, 0.f, 1.f, 1.f}};
+    std::vector<float> simulationData(nbValues - 10);
+    for (size_t i = 0; i < simulationData.size(); ++i)
+        simulationData[i] =
+            (i % 7 == 0 ? std::numeric_limits<float>::quiet_NaN()
+                        : random(seed));
+    const float scale = float(table.size() - 1);
+    grid.splat(simulationData, table, scale, 0.f);
+    for (const auto& cell : grid.cells)
+    {
+        double color[3] = {0.0, 0.0, 0.0};
+        double opacity = 0.0;
+        size_t nbSamples = 0;
+        for (size_t j = cell.begin; j < cell.end; ++j)
+        {
+            const auto offset = grid.offsets[j];
+            if (offset >= simulationData.size() ||
+                std::isnan(simulationData[offset]))
+                continue;
+            const auto sample = SimulationGrid::getTransferFunctionValue(
+                table, scale, 0.f, simulationData[offset]);
+            color[0] += sample.w * sample.x;
+            color[1] += sample.w * sample.y;
+            color[2] += sample.w * sample.z;
+            opacity += sample.w;
+            ++nbSamples;
+        }
+        const auto& c = grid.colors[cell.index];
+        const bool expected =
+            nbSamples == 0
+                ? c.x == 0.f && c.y == 0.f && c.z == 0.f && c.w == 0.f
+                : std::abs(c.x - color[0] / opacity) < 1e-5 &&
+                      std::abs(c.y - color[1] / opacity) < 1e-5 &&
+                      std::abs(c.z - color[2] / opacity) < 1e-5 &&
+                      std::abs(c.w - opacity / nbSamples) < 1e-5;
+        success &= check("Color of cell " + std::to_string(cell.index),
+                         expected);
+    }
+
+    // A resolution of 0 disables the grid
+    grid.assignPrimitives(primitives, 0);
+    success &= check("Disabled grid", grid.cells.empty() &&
+                                          grid.colors.empty());
+
+    // Coplanar primitives still fill a grid of at least one cell per axis
+    std::vector<Primitive> flat;
+    for (size_t i = 0; i < 100; ++i)
+        flat.push_back({{random(seed), random(seed), 0.f}, i + 1});
+    grid.assignPrimitives(flat, resolution);
+    size_t nbFlat = 0;
+    for (const auto& cell : grid.cells)
+        nbFlat += cell.end - cell.begin;
+    success &= check("Flat grid", grid.dimensions[2] == 1 && nbFlat == 100);
+
+    if (!success)
+        return EXIT_FAILURE;
+    std::cout << "Simulation grid bins every primitive in its cell"
+              << std::endl;
+    return EXIT_SUCCESS;
+}
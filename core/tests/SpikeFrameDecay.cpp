@@ -0,0 +1,220 @@
+/* Copyright (c) 2015-2018, EPFL/Blue Brain Project
+ * All rights reserved. Do not distribute without permission.
+ * Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * Checks the frames computed from the spike index against a brute-force scan
+ * of all the spikes. The spike handler depends on Brayns and Brain, the
+ * functions below therefore mirror, line for line, _loadSpikes and
+ * _computeFrame of SpikeSimulationHandler
+ * (plugin/neuroscience/neuron/SpikeSimulationHandler.cpp), and must be kept in
+ * sync with them.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+using floats = std::vector<float>;
+using Spike = std::pair<float, uint32_t>; // Time and GID
+
+const float DEFAULT_REST_VALUE = -80.f;
+const float DEFAULT_SPIKING_VALUE = -1.f;
+const float DEFAULT_TIME_INTERVAL = 0.01f;
+const float DEFAULT_DECAY_SPEED = 1.f;
+
+struct SpikeIndex
+{
+    floats times;
+    std::vector<uint32_t> offsets;
+};
+
+SpikeIndex loadSpikes(const std::set<uint32_t>& gids,
+                      const std::vector<Spike>& spikes)
+{
+    // Dense GID to frame offset table
+    const uint32_t invalidOffset = std::numeric_limits<uint32_t>::max();
+    const uint32_t minGid = gids.empty() ? 0 : *gids.begin();
+    const uint32_t maxGid = gids.empty() ? 0 : *gids.rbegin();
+    std::vector<uint32_t> gidOffsets(maxGid - minGid + 1, invalidOffset);
+    uint32_t offset = 0;
+    for (const auto gid : gids)
+        gidOffsets[gid - minGid] = offset++;
+
+    SpikeIndex index;
+    index.times.reserve(spikes.size());
+    index.offsets.reserve(spikes.size());
+    for (const auto& spike : spikes)
+    {
+        if (spike.second < minGid || spike.second > maxGid)
+            continue;
+        const auto spikeOffset = gidOffsets[spike.second - minGid];
+        if (spikeOffset == invalidOffset)
+            continue;
+        index.times.push_back(spike.first);
+        index.offsets.push_back(spikeOffset);
+    }
+
+    // Binary search requires spikes to be sorted by time
+    if (!std::is_sorted(index.times.begin(), index.times.end()))
+    {
+        std::vector<size_t> order(index.times.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(),
+                         [&index](const size_t a, const size_t b)
+                         { return index.times[a] < index.times[b]; });
+        floats times(order.size());
+        std::vector<uint32_t> offsets(order.size());
+        for (size_t i = 0; i < order.size(); ++i)
+        {
+            times[i] = index.times[order[i]];
+            offsets[i] = index.offsets[order[i]];
+        }
+        index.times = std::move(times);
+        index.offsets = std::move(offsets);
+    }
+    return index;
+}
+
+void computeFrame(const SpikeIndex& index, const float endTime,
+                  const float decayWindow, const float timestamp,
+                  floats& lastSpikeTimes, floats& frame)
+{
+    const float dt = DEFAULT_TIME_INTERVAL;
+    const float ts = std::min(timestamp, endTime);
+    const auto& times = index.times;
+    const auto& offsets = index.offsets;
+    const auto begin =
+        std::lower_bound(times.begin(), times.end(), ts - decayWindow);
+    const auto end = std::upper_bound(begin, times.end(), ts);
+
+    // Spikes are sorted by time, the last one of each cell is kept
+    std::fill(lastSpikeTimes.begin(), lastSpikeTimes.end(),
+              -std::numeric_limits<float>::max());
+    for (auto it = begin; it != end; ++it)
+        lastSpikeTimes[offsets[it - times.begin()]] = *it;
+
+    const float decayPerTimeUnit = DEFAULT_DECAY_SPEED / dt;
+    for (size_t i = 0; i < frame.size(); ++i)
+    {
+        const float elapsedTime = ts - lastSpikeTimes[i];
+        frame[i] =
+            std::max(DEFAULT_REST_VALUE,
+                     DEFAULT_SPIKING_VALUE - elapsedTime * decayPerTimeUnit);
+    }
+}
+
+// Value of a cell computed from all its spikes, without index nor window
+float bruteForceValue(const std::vector<Spike>& spikes, const uint32_t gid,
+                      const float endTime, const float timestamp)
+{
+    const float ts = std::min(timestamp, endTime);
+    float value = DEFAULT_REST_VALUE;
+    for (const auto& spike : spikes)
+    {
+        if (spike.second != gid || spike.first > ts)
+            continue;
+        const float elapsedTime = ts - spike.first;
+        value = std::max(value,
+                         DEFAULT_SPIKING_VALUE -
+                             elapsedTime * DEFAULT_DECAY_SPEED /
+                                 DEFAULT_TIME_INTERVAL);
+    }
+    return value;
+}
+
+// Deterministic pseudo-random numbers in [0, 1)
+float random(uint32_t& seed)
+{
+    seed = seed * 1664525u + 1013904223u;
+    return float(seed >> 8) / float(1u << 24);
+}
+} // namespace
+
+int main()
+{
+    // Cells with sparse GIDs, and spikes of cells that are not loaded
+    std::set<uint32_t> gids;
+    for (uint32_t gid = 10; gid < 200; gid += 3)
+        gids.insert(gid);
+
+    const float endTime = 5.f;
+    uint32_t seed = 42;
+    std::vector<Spike> spikes;
+    for (size_t i = 0; i < 2000; ++i)
+        spikes.push_back({endTime * random(seed),
+                          uint32_t(250 * random(seed))});
+    // Unsorted report, with simultaneous spikes of a same cell
+    spikes.push_back({1.f, 10});
+    spikes.push_back({1.f, 10});
+    spikes.push_back({endTime, 13});
+
+    const auto index = loadSpikes(gids, spikes);
+
+    bool success = true;
+    if (!std::is_sorted(index.times.begin(), index.times.end()))
+    {
+        std::cerr << "Spike index is not sorted" << std::endl;
+        success = false;
+    }
+
+    // Time needed for a spiking cell to get back to its resting value
+    const float decayWindow = DEFAULT_TIME_INTERVAL *
+                              (DEFAULT_SPIKING_VALUE - DEFAULT_REST_VALUE) /
+                              DEFAULT_DECAY_SPEED;
+
+    // Frames are visited in an arbitrary order, beyond the end of the report
+    floats lastSpikeTimes(gids.size());
+    floats frame(gids.size());
+    const uint32_t nbFrames = endTime / DEFAULT_TIME_INTERVAL;
+    for (const uint32_t f : {0u, 100u, 101u, 37u, 250u, 100u, nbFrames - 1,
+                             nbFrames, nbFrames + 20})
+    {
+        const float timestamp = f * DEFAULT_TIME_INTERVAL;
+        computeFrame(index, endTime, decayWindow, timestamp, lastSpikeTimes,
+                     frame);
+        size_t offset = 0;
+        for (const auto gid : gids)
+        {
+            const float expected =
+                bruteForceValue(spikes, gid, endTime, timestamp);
+            if (std::abs(frame[offset] - expected) > 1e-3f)
+            {
+                std::cerr << "Frame " << f << ", GID " << gid << ": got "
+                          << frame[offset] << ", expected " << expected
+                          << std::endl;
+                success = false;
+            }
+            ++offset;
+        }
+    }
+
+    if (!success)
+        return EXIT_FAILURE;
+    std::cout << "Spike frames match the brute-force decay" << std::endl;
+    return EXIT_SUCCESS;
+}
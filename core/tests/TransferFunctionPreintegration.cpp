@@ -0,0 +1,289 @@
+/* Copyright (c) 2015-2018, EPFL/Blue Brain Project
+ * All rights reserved. Do not distribute without permission.
+ * Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * Checks the preintegration of baked transfer functions against a brute-force
+ * fine sampling of the same table. The ISPC code cannot be called from C++, the
+ * functions below therefore mirror, line for line:
+ * - CircuitExplorerSimulationRenderer::_bakeTransferFunction (.cpp)
+ * - getTransferFunctionValue, getTransferFunctionIntegral and
+ *   getPreintegratedTransferFunctionValue
+ *   (CircuitExplorerSimulationRenderer.ih)
+ * and must be kept in sync with them.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+struct vec4f
+{
+    float x, y, z, w;
+};
+
+vec4f operator+(const vec4f& a, const vec4f& b)
+{
+    return {a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w};
+}
+
+vec4f operator-(const vec4f& a, const vec4f& b)
+{
+    return {a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w};
+}
+
+vec4f operator*(const float s, const vec4f& a)
+{
+    return {s * a.x, s * a.y, s * a.z, s * a.w};
+}
+
+vec4f premultiply(const vec4f& a)
+{
+    return {a.x * a.w, a.y * a.w, a.z * a.w, a.w};
+}
+
+vec4f unpremultiply(const vec4f& a)
+{
+    if (a.w <= 0.f)
+        return {0.f, 0.f, 0.f, 0.f};
+    return {a.x / a.w, a.y / a.w, a.z / a.w, a.w};
+}
+
+// Number of entries of the baked transfer functions
+const size_t TRANSFER_FUNCTION_TABLE_SIZE = 1024;
+
+struct BakedTransferFunction
+{
+    std::vector<vec4f> table;
+    std::vector<vec4f> integral;
+    float scale;
+    float offset;
+};
+
+float sampleLinearly(const std::vector<float>& values, const float position)
+{
+    const float x = position * (values.size() - 1);
+    const size_t index = std::min(size_t(x), values.size() - 2);
+    const float weight = x - index;
+    return values[index] * (1.f - weight) + values[index + 1] * weight;
+}
+
+BakedTransferFunction bake(const std::vector<float>& reds,
+                           const std::vector<float>& greens,
+                           const std::vector<float>& blues,
+                           const std::vector<float>& opacities,
+                           const float minValue, const float maxValue)
+{
+    BakedTransferFunction baked;
+    baked.table.resize(TRANSFER_FUNCTION_TABLE_SIZE);
+    for (size_t i = 0; i < TRANSFER_FUNCTION_TABLE_SIZE; ++i)
+    {
+        const float position = float(i) / (TRANSFER_FUNCTION_TABLE_SIZE - 1);
+        baked.table[i] = {sampleLinearly(reds, position),
+                          sampleLinearly(greens, position),
+                          sampleLinearly(blues, position),
+                          sampleLinearly(opacities, position)};
+    }
+
+    baked.integral.resize(TRANSFER_FUNCTION_TABLE_SIZE);
+    baked.integral[0] = {0.f, 0.f, 0.f, 0.f};
+    for (size_t i = 1; i < TRANSFER_FUNCTION_TABLE_SIZE; ++i)
+        baked.integral[i] =
+            baked.integral[i - 1] +
+            0.5f * (premultiply(baked.table[i - 1]) +
+                    premultiply(baked.table[i]));
+
+    baked.scale = (TRANSFER_FUNCTION_TABLE_SIZE - 1) / (maxValue - minValue);
+    baked.offset = -minValue * baked.scale;
+    return baked;
+}
+
+vec4f getTransferFunctionValue(const BakedTransferFunction& baked,
+                               const float value)
+{
+    if (std::isnan(value))
+        return {0.f, 0.f, 0.f, 0.f};
+
+    const float last = float(baked.table.size() - 1);
+    const float x =
+        std::min(last, std::max(0.f, value * baked.scale + baked.offset));
+    const int index = std::min(int(x), int(baked.table.size()) - 2);
+    const float weight = x - float(index);
+    return (1.f - weight) * baked.table[index] +
+           weight * baked.table[index + 1];
+}
+
+vec4f getTransferFunctionIntegral(const BakedTransferFunction& baked,
+                                  const float x)
+{
+    const int last = baked.table.size() - 1;
+    const vec4f first = baked.table[0];
+    const vec4f end = baked.table[last];
+    if (x <= 0.f)
+        return x * premultiply(first);
+    if (x >= float(last))
+        return baked.integral[last] + (x - float(last)) * premultiply(end);
+
+    const int index = std::min(int(x), last - 1);
+    const float weight = x - float(index);
+    const vec4f pa = premultiply(baked.table[index]);
+    const vec4f pb = premultiply(baked.table[index + 1]);
+    return baked.integral[index] + weight * pa +
+           (0.5f * weight * weight) * (pb - pa);
+}
+
+vec4f getPreintegratedTransferFunctionValue(const BakedTransferFunction& baked,
+                                            const float front,
+                                            const float back)
+{
+    if (std::isnan(front))
+        return getTransferFunctionValue(baked, back);
+    if (std::isnan(back))
+        return {0.f, 0.f, 0.f, 0.f};
+
+    const float xFront = front * baked.scale + baked.offset;
+    const float xBack = back * baked.scale + baked.offset;
+    const float span = xBack - xFront;
+    if (std::abs(span) < 1.f)
+        return getTransferFunctionValue(baked, back);
+
+    const vec4f sum =
+        (1.f / span) * (getTransferFunctionIntegral(baked, xBack) -
+                        getTransferFunctionIntegral(baked, xFront));
+    return unpremultiply(sum);
+}
+
+// Integral of the premultiplied table from 0 to x, by the midpoint rule
+vec4f bruteForceIntegral(const BakedTransferFunction& baked, const float x)
+{
+    const float last = float(baked.table.size() - 1);
+    const size_t nbSamples = 1000 * (size_t(std::abs(x)) + 1);
+    const double step = double(x) / nbSamples;
+    double sum[4] = {0.0, 0.0, 0.0, 0.0};
+    for (size_t i = 0; i < nbSamples; ++i)
+    {
+        const float t = float((i + 0.5) * step);
+        const float clamped = std::min(last, std::max(0.f, t));
+        const int index = std::min(int(clamped), int(last) - 1);
+        const float weight = clamped - float(index);
+        const vec4f value =
+            (1.f - weight) * premultiply(baked.table[index]) +
+            weight * premultiply(baked.table[index + 1]);
+        sum[0] += value.x * step;
+        sum[1] += value.y * step;
+        sum[2] += value.z * step;
+        sum[3] += value.w * step;
+    }
+    return {float(sum[0]), float(sum[1]), float(sum[2]), float(sum[3])};
+}
+
+// What a renderer converges to when the ray segment is sampled finely: the
+// average of the point-sampled, opacity-weighted values along the segment
+vec4f bruteForceSegment(const BakedTransferFunction& baked, const float front,
+                        const float back)
+{
+    const size_t nbSamples = 100000;
+    double sum[4] = {0.0, 0.0, 0.0, 0.0};
+    for (size_t i = 0; i < nbSamples; ++i)
+    {
+        const float t = float((i + 0.5) / nbSamples);
+        const float value = front + t * (back - front);
+        const vec4f sample =
+            premultiply(getTransferFunctionValue(baked, value));
+        sum[0] += sample.x;
+        sum[1] += sample.y;
+        sum[2] += sample.z;
+        sum[3] += sample.w;
+    }
+    return unpremultiply({float(sum[0] / nbSamples), float(sum[1] / nbSamples),
+                          float(sum[2] / nbSamples),
+                          float(sum[3] / nbSamples)});
+}
+
+bool check(const std::string& name, const vec4f& value, const vec4f& expected,
+           const float tolerance)
+{
+    const float error = std::max(std::max(std::abs(value.x - expected.x),
+                                          std::abs(value.y - expected.y)),
+                                 std::max(std::abs(value.z - expected.z),
+                                          std::abs(value.w - expected.w)));
+    if (error <= tolerance)
+        return true;
+    std::cerr << name << ": got (" << value.x << ", " << value.y << ", "
+              << value.z << ", " << value.w << "), expected (" << expected.x
+              << ", " << expected.y << ", " << expected.z << ", " << expected.w
+              << "), error " << error << std::endl;
+    return false;
+}
+} // namespace
+
+int main()
+{
+    // Voltage-like transfer function with a thin opacity spike around -55 mV,
+    // a feature that large sampling steps would step over
+    std::vector<float> reds, greens, blues, opacities;
+    const size_t nbControlPoints = 64;
+    for (size_t i = 0; i < nbControlPoints; ++i)
+    {
+        const float position = float(i) / (nbControlPoints - 1);
+        reds.push_back(position);
+        greens.push_back(0.5f + 0.5f * std::sin(6.f * position));
+        blues.push_back(1.f - position);
+        opacities.push_back(i == 22 ? 1.f : 0.05f * position);
+    }
+    const float minValue = -80.f;
+    const float maxValue = -10.f;
+    const auto baked =
+        bake(reds, greens, blues, opacities, minValue, maxValue);
+
+    bool success = true;
+    const float last = float(TRANSFER_FUNCTION_TABLE_SIZE - 1);
+    for (const float x : {-3.5f, 0.f, 0.3f, 17.25f, 352.f, 355.7f, 1000.5f,
+                          last, last + 6.8f})
+        success &= check("Integral at " + std::to_string(x),
+                         getTransferFunctionIntegral(baked, x),
+                         bruteForceIntegral(baked, x), 1e-3f * (1.f + x / 64));
+
+    const std::vector<std::pair<float, float>> segments = {
+        {-79.f, -70.f},   // Smooth part of the transfer function
+        {-58.f, -52.f},   // Across the spike
+        {-52.f, -58.f},   // Across the spike, backwards
+        {-56.f, -55.f},   // Within the spike
+        {-90.f, -75.f},   // Starting below the range of the table
+        {-30.f, 5.f},     // Ending above the range of the table
+        {-40.f, -40.03f}, // Less than a table entry, point sampled
+    };
+    for (const auto& segment : segments)
+        success &= check("Segment [" + std::to_string(segment.first) + ", " +
+                             std::to_string(segment.second) + "]",
+                         getPreintegratedTransferFunctionValue(
+                             baked, segment.first, segment.second),
+                         bruteForceSegment(baked, segment.first,
+                                           segment.second),
+                         2e-3f);
+
+    if (!success)
+        return EXIT_FAILURE;
+    std::cout << "Transfer function preintegration matches brute force"
+              << std::endl;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,149 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+
+# Copyright (c) 2016-2019, Blue Brain Project
+#                          Cyrille Favreau <cyrille.favreau@epfl.ch>
+#
+# This file is part of Brayns <https://github.com/favreau/CircuitExplorer>
+#
+# This library is free software; you can redistribute it and/or modify it under
+# the terms of the GNU Lesser General Public License version 3.0 as published
+# by the Free Software Foundation.
+#
+# This library is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+# FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+# details.
+#
+# You should have received a copy of the GNU Lesser General Public License
+# along with this library; if not, write to the Free Software Foundation, Inc.,
+# 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+# All rights reserved. Do not distribute without further notice.
+
+"""
+Compares the cost of the advanced renderer with and without specialized kernels.
+
+The scene of a running CircuitExplorer instance is rendered with the
+specializedKernels renderer property off, then on, the other renderer
+properties being left untouched. For each mode, the cycles spent per sample are
+read from the render statistics of consecutive frames, and their median is
+reported along with the speedup of the specialized kernels.
+
+Example:
+    python specialized_kernels.py --url localhost:5000 \\
+        --circuit /path/to/BlueConfig --targets mini50 --frames 32
+"""
+
+import argparse
+import statistics
+import time
+
+from brayns import Client
+from circuitexplorer import CircuitExplorer
+
+RENDERER = 'circuit_explorer_advanced'
+
+
+def collect_frames(brayns, circuit_explorer, specialized_kernels, nb_frames,
+                   nb_warmup_frames, timeout):
+    """
+    Render frames in the given mode and return their render statistics
+
+    :param Client brayns: Brayns client
+    :param CircuitExplorer circuit_explorer: Circuit Explorer API
+    :param bool specialized_kernels: Use kernels specialized for enabled features
+    :param int nb_frames: Number of frames to collect
+    :param int nb_warmup_frames: Number of frames ignored before collecting
+    :param float timeout: Maximum time spent collecting frames, in seconds
+    :return: Statistics of the collected frames
+    :rtype: list
+    """
+    params = brayns.CircuitExplorerAdvancedRendererParams()
+    params.specialized_kernels = specialized_kernels
+    params.render_statistics = True
+    brayns.set_renderer_params(params)
+
+    # Changing the renderer parameters resets the accumulation, frames are
+    # then rendered until max_accum_frames is reached
+    frames = list()
+    last = None
+    nb_skipped_frames = 0
+    start = time.time()
+    while len(frames) < nb_frames and time.time() - start < timeout:
+        time.sleep(0.01)
+        frame = circuit_explorer.get_render_statistics()
+        if not frame['available'] or frame == last:
+            continue
+        last = frame
+        if frame['samples'] == 0:
+            continue
+        if nb_skipped_frames < nb_warmup_frames:
+            nb_skipped_frames += 1
+            continue
+        frames.append(frame)
+    if len(frames) < nb_frames:
+        print('Warning: only %d frames were collected' % len(frames))
+    return frames
+
+
+def summarize(frames):
+    """Return the median cycles and rays per sample of a list of frames"""
+    def median(key):
+        return statistics.median(
+            [float(frame[key]) / frame['samples'] for frame in frames])
+    return {
+        'cycles': median('cycles'),
+        'cameraRays': median('cameraRays'),
+        'shadowRays': median('shadowRays'),
+        'indirectRays': median('indirectRays'),
+        'simulationRays': median('simulationRays'),
+        'volumeSamples': median('volumeSamples')
+    }
+
+
+def main():
+    """Run the benchmark"""
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[1])
+    parser.add_argument('--url', default='localhost:5000',
+                        help='Address of the CircuitExplorer instance')
+    parser.add_argument('--circuit', default='',
+                        help='BlueConfig loaded before rendering (the current '
+                        'scene is used if empty)')
+    parser.add_argument('--targets', nargs='*', default=list(),
+                        help='Targets of the circuit to load')
+    parser.add_argument('--frames', type=int, default=32,
+                        help='Number of frames collected per mode')
+    parser.add_argument('--warmup', type=int, default=4,
+                        help='Number of frames ignored before collecting')
+    parser.add_argument('--timeout', type=float, default=300.0,
+                        help='Maximum time spent collecting frames per mode, '
+                        'in seconds')
+    args = parser.parse_args()
+
+    brayns = Client(args.url)
+    circuit_explorer = CircuitExplorer(brayns)
+    if args.circuit:
+        circuit_explorer.load_circuit(path=args.circuit, targets=args.targets)
+
+    brayns.set_renderer(current=RENDERER, subsampling=1,
+                        max_accum_frames=args.warmup + 4 * args.frames)
+
+    results = dict()
+    for specialized_kernels in [False, True]:
+        frames = collect_frames(
+            brayns, circuit_explorer, specialized_kernels, args.frames,
+            args.warmup, args.timeout)
+        if not frames:
+            raise RuntimeError('No render statistics were collected. Is the '
+                               'scene empty?')
+        results[specialized_kernels] = summarize(frames)
+
+    print('%-16s %14s %14s' % ('Per sample', 'Generic', 'Specialized'))
+    for key in results[False]:
+        print('%-16s %14.1f %14.1f' % (
+            key, results[False][key], results[True][key]))
+    print('Speedup: %.2fx' % (results[False]['cycles'] / results[True]['cycles']))
+
+
+if __name__ == '__main__':
+    main()
@@ -100,6 +100,7 @@ class CircuitExplorer:
     CLIPPING_MODE_NONE = 0
     CLIPPING_MODE_PLANE = 1
     CLIPPING_MODE_SPHERE = 2
+    CLIPPING_MODE_BOX = 3
 
     # Simulation report types
     REPORT_TYPE_NONE = 'Undefined'
@@ -133,8 +134,10 @@ class CircuitExplorer:
                      random_seed=0, targets=list(), report='',
                      report_type=REPORT_TYPE_VOLTAGES_FROM_FILE,
                      user_data_type=USER_DATATYPE_SIMULATION_OFFSET, synchronous_mode=True,
+                     prefetch_depth=2, frame_cache_size=1024, replay_file='',
                      circuit_color_scheme=CIRCUIT_COLOR_SCHEME_NONE, mesh_folder='',
-                     mesh_filename_pattern='', mesh_transformation=False, radius_multiplier=1,
+                     mesh_filename_pattern='', mesh_transformation=False,
+                     max_distance_to_simulation_model=30.0, radius_multiplier=1,
                      radius_correction=0, load_soma=True, load_axon=True, load_dendrite=True,
                      load_apical_dendrite=True, use_sdf_soma=False, use_sdf_branches=False,
                      use_sdf_nucleus=False, use_sdf_mitochonria=False, use_sdf_synapses=False,
@@ -160,6 +163,9 @@ class CircuitExplorer:
         USER_DATATYPE_SIMULATION_OFFSET, USER_DATATYPE_DISTANCE_TO_SOMA)
         :param bool synchronous_mode: Defines if the simulation report should be loaded
         synchronously or not
+        :param int prefetch_depth: Number of simulation frames loaded ahead of playback
+        :param int frame_cache_size: Memory budget of the simulation frame cache, in megabytes
+        :param str replay_file: Quantized replay file used instead of the compartment report
         :param int circuit_color_scheme: Color scheme to apply to the circuit (
         CIRCUIT_COLOR_SCHEME_NONE, CIRCUIT_COLOR_SCHEME_NEURON_BY_ID,
         CIRCUIT_COLOR_SCHEME_NEURON_BY_LAYER, CIRCUIT_COLOR_SCHEME_NEURON_BY_MTYPE,
@@ -169,6 +175,8 @@ class CircuitExplorer:
         replaced by the correponding GID during the loading of the circuit. e.g. mesh_{gid}.obj)
         :param bool mesh_transformation: Boolean defining is circuit transformation should be
         applied to the meshes
+        :param float max_distance_to_simulation_model: Maximum distance between the meshes and
+        the simulation model they are mapped to when loading the circuit (0 to disable mapping)
         :param float radius_multiplier: Multiplies morphology radius by the specified value
         :param float radius_correction: Forces morphology radii to the specified value
         :param bool load_soma: Defines if the somas should be loaded
@@ -224,12 +232,16 @@ class CircuitExplorer:
         props['021ReportType'] = report_type
         props['022UserDataType'] = user_data_type
         props['023SynchronousMode'] = synchronous_mode
+        props['024PrefetchDepth'] = prefetch_depth
+        props['025FrameCacheSize'] = frame_cache_size
+        props['026ReplayFile'] = replay_file
 
         props['030CircuitColorScheme'] = circuit_color_scheme
 
         props['040MeshFolder'] = mesh_folder
         props['041MeshFilenamePattern'] = mesh_filename_pattern
         props['042MeshTransformation'] = mesh_transformation
+        props['043MaxDistanceToSimulationModel'] = max_distance_to_simulation_model
 
         props['050RadiusMultiplier'] = radius_multiplier
         props['051RadiusCorrection'] = radius_correction
@@ -439,7 +451,7 @@ class CircuitExplorer:
         SHADING_MODE_ELECTRON, SHADING_MODE_CARTOON, SHADING_MODE_ELECTRON_TRANSPARENCY,
         SHADING_MODE_PERLIN or SHADING_MODE_DIFFUSE_TRANSPARENCY)
         :param float emission: Light emission intensity
-        :param bool clipping_mode: Clipped against clipping planes/spheres defined at the scene
+        :param bool clipping_mode: Clipped against clipping planes/spheres/boxes defined at the scene
         level
         :param float user_parameter: Convenience parameter used by some of the shaders
         :return: Result of the request submission
@@ -543,7 +555,7 @@ class CircuitExplorer:
         SHADING_MODE_ELECTRON, SHADING_MODE_CARTOON, SHADING_MODE_ELECTRON_TRANSPARENCY,
         SHADING_MODE_PERLIN or SHADING_MODE_DIFFUSE_TRANSPARENCY)
         :param float emission: Light emission intensity
-        :param bool clipping_mode: Clipped against clipping planes/spheres defined at the scene
+        :param bool clipping_mode: Clipped against clipping planes/spheres/boxes defined at the scene
         level
         :param float user_parameter: Convenience parameter used by some of the shaders
         :return: Result of the request submission
@@ -940,6 +952,141 @@ class CircuitExplorer:
         return self._client.request(self.PLUGIN_API_PREFIX + 'get-material-ids', params,
                                     response_timeout=self.DEFAULT_RESPONSE_TIMEOUT)
 
+    # pylint: disable=R0913
+    def attach_circuit_simulation_handler(self, model_id, circuit_configuration, report_name,
+                                          synchronous_mode=False, prefetch_depth=None,
+                                          frame_cache_size=None):
+        """
+        Attach a voltage simulation handler to an existing model
+
+        :param int model_id: ID of the model
+        :param str circuit_configuration: Path to the BlueConfig of the circuit
+        :param str report_name: Name of the compartment report
+        :param bool synchronous_mode: Wait for simulation frames to be loaded before rendering
+        :param int prefetch_depth: Number of simulation frames loaded ahead of playback (server
+        default if None)
+        :param int frame_cache_size: Memory budget of the simulation frame cache, in MB (server
+        default if None)
+        :return: Result of the request submission
+        :rtype: str
+        """
+        params = dict()
+        params['modelId'] = model_id
+        params['circuitConfiguration'] = circuit_configuration
+        params['reportName'] = report_name
+        params['synchronousMode'] = synchronous_mode
+        if prefetch_depth is not None:
+            params['prefetchDepth'] = prefetch_depth
+        if frame_cache_size is not None:
+            params['frameCacheSize'] = frame_cache_size
+        return self._client.request(
+            self.PLUGIN_API_PREFIX + 'attach-circuit-simulation-handler', params,
+            response_timeout=self.DEFAULT_RESPONSE_TIMEOUT)
+
+    def get_voltage_simulation_statistics(self, model_id):
+        """
+        Return frame loading statistics of the voltage simulation attached to a model
+
+        :param int model_id: ID of the model
+        :return: Prefetch depth, number of loaded frames, last and average frame wait times (ms)
+        :rtype: dict
+        """
+        params = dict()
+        params['modelId'] = model_id
+        return self._client.request(
+            self.PLUGIN_API_PREFIX + 'get-voltage-simulation-statistics', params,
+            response_timeout=self.DEFAULT_RESPONSE_TIMEOUT)
+
+    def create_voltage_replay_file(self, model_id, path, bits_per_value=16,
+                                   per_frame_scaling=False, value_range=(-80.0, -10.0)):
+        """
+        Start the creation of a local replay file with quantized voltages. The creation runs in
+        the background, and the replay file is used for the playback once it is complete. Use
+        get_voltage_replay_file_status to follow its progress
+
+        :param int model_id: ID of the model
+        :param str path: Path to the replay file
+        :param int bits_per_value: Number of bits per quantized value (8 or 16)
+        :param bool per_frame_scaling: Quantize values within the range of each frame
+        :param list value_range: Range of voltages used if per_frame_scaling is False
+        :return: Result of the request submission
+        :rtype: dict
+        """
+        params = dict()
+        params['modelId'] = model_id
+        params['path'] = path
+        params['bitsPerValue'] = bits_per_value
+        params['perFrameScaling'] = per_frame_scaling
+        params['minValue'] = value_range[0]
+        params['maxValue'] = value_range[1]
+        return self._client.request(
+            self.PLUGIN_API_PREFIX + 'create-voltage-replay-file', params,
+            response_timeout=self.DEFAULT_RESPONSE_TIMEOUT)
+
+    def get_voltage_replay_file_status(self):
+        """
+        Get the status of the creation of a voltage replay file
+
+        :return: Whether the creation is running, its progress (0 to 1), its status and error
+        message, and the maximum and RMS quantization errors once complete
+        :rtype: dict
+        """
+        return self._client.request(
+            self.PLUGIN_API_PREFIX + 'get-voltage-replay-file-status',
+            response_timeout=self.DEFAULT_RESPONSE_TIMEOUT)
+
+    def set_voltage_replay_file(self, model_id, path):
+        """
+        Use an existing replay file for the playback of a voltage simulation
+
+        :param int model_id: ID of the model
+        :param str path: Path to the replay file (empty to use the compartment report)
+        :return: Result of the request submission
+        :rtype: str
+        """
+        params = dict()
+        params['modelId'] = model_id
+        params['path'] = path
+        return self._client.request(
+            self.PLUGIN_API_PREFIX + 'set-voltage-replay-file', params,
+            response_timeout=self.DEFAULT_RESPONSE_TIMEOUT)
+
+    def get_render_statistics(self):
+        """
+        Get the statistics of the last frame rendered with the renderStatistics renderer property
+        enabled: number of samples, cycles, camera, shadow, indirect and simulation rays, volume
+        samples, and the cycles spent on every tile of the frame (cost heatmap, row by row)
+
+        :return: Statistics of the last frame, if available
+        :rtype: dict
+        """
+        return self._client.request(
+            self.PLUGIN_API_PREFIX + 'get-render-statistics',
+            response_timeout=self.DEFAULT_RESPONSE_TIMEOUT)
+
+    def get_simulation_frame_statistics(self, model_id, frame):
+        """
+        Get the statistics (min, max, mean and histogram) of a simulation frame
+
+        Statistics are computed in the background, one frame at a time, for the
+        frames that have been loaded by the simulation handler, i.e. the frames
+        visited by the playback and the ones it prefetched. Frames that were
+        never loaded have no statistics, and frames loaded faster than the
+        statistics are computed may be skipped. 'available' is False in both
+        cases.
+
+        :param int model_id: ID of the model
+        :param int frame: Simulation frame
+        :return: Statistics of the frame, if already computed
+        :rtype: dict
+        """
+        params = dict()
+        params['modelId'] = model_id
+        params['frame'] = frame
+        return self._client.request(
+            self.PLUGIN_API_PREFIX + 'get-simulation-frame-statistics', params,
+            response_timeout=self.DEFAULT_RESPONSE_TIMEOUT)
+
 
     def import_compartment_simulation(self, db_connection_string, db_schema, blue_config, report_name, report_id):
         params = dict()